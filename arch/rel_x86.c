@@ -188,3 +188,22 @@ u8 loader_apply_relocation(
 	return 0;
 
 }
+
+/**
+ * loader_cycles : reads the processor's cycle counter;
+ * This function is processor-defined;
+ * @return the current value of the time stamp counter;
+ */
+u64 loader_cycles(void)
+{
+
+	u32 low;
+	u32 high;
+
+	/*Read the time stamp counter;*/
+	__asm__ __volatile__ ("rdtsc" : "=a" (low), "=d" (high));
+
+	/*Merge both halves;*/
+	return ((u64) high << 32) | low;
+
+}
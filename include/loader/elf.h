@@ -368,7 +368,7 @@ rel_error_t elf_identifier_check(struct elf_identifier *, u8 elf_64);
 #define SHF_ALLOC (1 << 1)
 
 /*Section contains executable machine instructions;*/
-#define SHF_EXECINSTR (1 >> 2)
+#define SHF_EXECINSTR (1 << 2)
 
 /*Reserved flags;*/
 #define SHF_MASKPROC 0xf0000000
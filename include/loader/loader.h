@@ -7,6 +7,8 @@
 
 #include <loader/elf64.h>
 
+#include <loader/namespace.h>
+
 /**
  * The byte table struct contains data to describe an abstract byte table,
  * that contains a given number of entries, of a constant size;
@@ -74,6 +76,67 @@ struct loader_symbol {
 /*A relocation symbol had a null address;*/
 #define LOADER_ERROR_REL_VALUE_OVERFLOW ((u8) 8)
 
+/*An index was provided with an invalid number of buckets or bloom words;*/
+#define LOADER_ERROR_BAD_INDEX_SIZE ((u8) 9)
+
+/*A memory region was too small to hold the sections assigned to it;*/
+#define LOADER_ERROR_REGION_TOO_SMALL ((u8) 10)
+
+
+/*
+ * Loading phases, used to index cycle counters;
+ */
+
+/*Environment initialization;*/
+#define LOADER_PHASE_INIT ((u8) 0)
+
+/*Sections layout;*/
+#define LOADER_PHASE_LAYOUT ((u8) 1)
+
+/*Symbols assignment;*/
+#define LOADER_PHASE_SYMBOLS ((u8) 2)
+
+/*Relocations application;*/
+#define LOADER_PHASE_RELOCATIONS ((u8) 3)
+
+/*The number of loading phases;*/
+#define LOADER_NB_PHASES 4
+
+/*The number of relocation type counters; greater types share the last one;*/
+#define LOADER_STATS_NB_REL_TYPES 48
+
+/**
+ * The loader stats struct collects counters related to the loading of one or
+ * more elf files; it is updated only if referenced by the loading
+ * environment;
+ */
+struct loader_stats {
+
+	/*Processor cycles spent in each phase;*/
+	u64 s_cycles[LOADER_NB_PHASES];
+
+	/*The number of symbols defined in the file;*/
+	usize s_syms_internal;
+
+	/*The number of undefined symbols resolved with external definitions;*/
+	usize s_syms_external;
+
+	/*The number of undefined symbols that remained unresolved;*/
+	usize s_syms_unresolved;
+
+	/*The number of symbol queries defined by the file;*/
+	usize s_syms_queried;
+
+	/*The number of relocations applied, per relocation type;*/
+	usize s_relocations[LOADER_STATS_NB_REL_TYPES];
+
+	/*Lookup counters for external definitions;*/
+	struct loader_probe_stats s_probes;
+
+	/*The number of bytes of elf tables walked by the loader;*/
+	usize s_bytes_touched;
+
+};
 
 /**
  * The loading environment contains data related to a relocatable elf file
@@ -90,6 +153,9 @@ struct loading_env {
 	/*The an internal context to restore in case of internal error;*/
 	struct rest_ctx *r_error_ctx;
 
+	/*Statistics to update during the loading, 0 if disabled;*/
+	struct loader_stats *r_stats;
+
 };
 
 /**
@@ -103,6 +169,47 @@ void loader_init(
 		void *ram_start
 );
 
+/**
+ * loader_init_stats : initializes the loading environment for the provided
+ * elf file, and makes all loading phases update the provided stats;
+ * Stats are not reset, so that they can be accumulated over several loads;
+ * @param env : the environment to initialize;
+ * @param ram_start : the address of the file's first byte in RAM;
+ * @param stats : the stats to update, 0 to disable instrumentation;
+ */
+void loader_init_stats(
+		struct loading_env *env,
+		void *ram_start,
+		struct loader_stats *stats
+);
+
+/**
+ * loader_stats_reset : resets all counters of the provided stats;
+ * @param stats : the stats to reset;
+ */
+void loader_stats_reset(struct loader_stats *stats);
+
+/**
+ * loader_stats_dump : reports each counter of the provided stats, by calling
+ * @emit with the counter's name and value; relocation types with no
+ * occurrence are not reported;
+ * @param stats : the stats to dump;
+ * @param emit : the function to call for each counter;
+ * @param arg : the first argument to pass to @emit;
+ */
+void loader_stats_dump(
+		struct loader_stats *stats,
+		void (*emit)(void *arg, const char *name, usize index, u64 value),
+		void *arg
+);
+
+/**
+ * loader_cycles : reads the processor's cycle counter;
+ * This function is processor-defined;
+ * @return the current value of the cycle counter;
+ */
+u64 loader_cycles(void);
+
 /**
  * loader_assign_sections : update all section's values to their RAM addresses;
  * @param env : the loading environment;
@@ -140,6 +247,275 @@ u16 loader_assign_symbols(
 	struct loader_symbol *undefs
 );
 
+/**
+ * loader_assign_symbols_ns : same as loader_assign_symbols, except that
+ * undefined symbols are resolved against the layers of a namespace, the
+ * first layer from the top that defines a symbol providing its value;
+ * Most misses are rejected by each layer's bloom filter;
+ * @param env : the loading environment
+ * @param ns : the namespace providing definitions;
+ * @param undefs : a set of symbols the executable may define; if defined
+ * symbols with matching names are found in the executable, the list will be
+ * updated with the value of the symbol in the executable;
+ * @return 0 if all symbols had their value assigned, or the loading error;
+ */
+u16 loader_assign_symbols_ns(
+	struct loading_env *env,
+	struct loader_namespace *ns,
+	struct loader_symbol *undefs
+);
+
+/*
+ * Profile-guided text layout;
+ *
+ * After sections assignment, executable sections can be copied out of the
+ * file into a hot region and a cold region : sections that the profile
+ * reports at or above the hot threshold are placed in the hot region, in
+ * the profile's order, and all other executable sections are placed in the
+ * cold region, in file order; symbols and relocations then use the new
+ * addresses;
+ */
+
+/**
+ * A profile entry gives the weight of a section, designated by its name
+ * (".text.foo") or by its function's name ("foo", for -ffunction-sections
+ * builds);
+ */
+struct loader_profile_entry {
+
+	/*The name of the section or function;*/
+	const char *p_name;
+
+	/*The weight of the entry, higher is hotter;*/
+	usize p_weight;
+
+	/*Scratch : the index of the matching section, 0 if none;*/
+	u16 p_section;
+
+};
+
+/**
+ * A loader profile references entries, sorted by decreasing weight, and an
+ * index over their names;
+ */
+struct loader_profile {
+
+	/*The entries, sorted by decreasing weight;*/
+	struct loader_profile_entry *p_entries;
+
+	/*The number of entries;*/
+	usize p_nb_entries;
+
+	/*The minimal weight of a hot section;*/
+	usize p_hot_threshold;
+
+	/*The index over entry names, each export's address references its entry;*/
+	struct loader_export_table p_index;
+
+};
+
+/**
+ * loader_profile_init : sorts the profile's entries by decreasing weight and
+ * builds the index over their names;
+ * @param profile : the profile to initialize;
+ * @param entries : the profile entries;
+ * @param nb_entries : the number of entries;
+ * @param hot_threshold : the minimal weight of a hot section;
+ * @param exports : the index's exports, one per entry;
+ * @param buckets : the index's buckets;
+ * @param nb_buckets : the number of buckets, must not be null;
+ * @param bloom : the index's bloom filter;
+ * @param bloom_words : the number of bloom words, must be a power of 2;
+ * @return 0 if the profile was initialized, or the loading error;
+ */
+u8 loader_profile_init(
+	struct loader_profile *profile,
+	struct loader_profile_entry *entries,
+	usize nb_entries,
+	usize hot_threshold,
+	struct loader_export *exports,
+	struct loader_export **buckets,
+	usize nb_buckets,
+	usize *bloom,
+	usize bloom_words
+);
+
+/**
+ * loader_text_size : determines the size of a region able to hold all
+ * executable sections of the environment;
+ * @param env : the loading environment;
+ * @return the size in bytes, alignment paddings included;
+ */
+usize loader_text_size(struct loading_env *env);
+
+/**
+ * loader_reorder_text : copies executable sections to the hot and cold
+ * regions according to the profile, and updates their addresses; must be
+ * called after loader_assign_sections, and before symbols assignment;
+ * @param env : the loading environment;
+ * @param profile : the initialized profile;
+ * @param hot : the start of the hot region;
+ * @param hot_size : the size of the hot region;
+ * @param cold : the start of the cold region;
+ * @param cold_size : the size of the cold region;
+ * @return 0 if all sections were placed, or the loading error;
+ */
+u8 loader_reorder_text(
+	struct loading_env *env,
+	struct loader_profile *profile,
+	void *hot,
+	usize hot_size,
+	void *cold,
+	usize cold_size
+);
+
+/*
+ * Parallel symbols assignment;
+ *
+ * Symbols of all symbol tables are numbered in section order, and split in
+ * chunks that can be processed concurrently by any worker pool; chunks
+ * resolve undefined symbols against a read-only namespace, and publish
+ * definitions to a read-only, bloom-fronted query index; when several
+ * symbols define the same query, the one with the lowest index wins, as in
+ * the serial assignment, whatever the execution order of chunks;
+ */
+
+/**
+ * The symbols job contains data shared by all chunks of a parallel symbols
+ * assignment;
+ */
+struct loader_symbols_job {
+
+	/*The loading environment;*/
+	struct loading_env *j_env;
+
+	/*The namespace providing external definitions;*/
+	struct loader_namespace *j_defs;
+
+	/*The query index, each export's address references its query;*/
+	struct loader_export_table j_queries;
+
+	/*The query index's exports;*/
+	struct loader_export *j_query_exports;
+
+	/*The lowest index of a symbol defining each query, -1 if none;*/
+	usize *j_winners;
+
+	/*The number of queries;*/
+	usize j_nb_queries;
+
+	/*The total number of symbols;*/
+	usize j_nb_symbols;
+
+};
+
+/**
+ * A symbols chunk is a slice of the job's symbols processed by one worker;
+ */
+struct loader_symbols_chunk {
+
+	/*The job the chunk belongs to;*/
+	struct loader_symbols_job *c_job;
+
+	/*The global index of the first symbol of the chunk;*/
+	usize c_first;
+
+	/*The number of symbols of the chunk;*/
+	usize c_count;
+
+	/*The loading error of the chunk, 0 if none;*/
+	u8 c_error;
+
+	/*The chunk's private stats, merged at completion;*/
+	struct loader_stats c_stats;
+
+};
+
+/**
+ * loader_symbols_job_init : prepares the parallel assignment of all symbols of
+ * the environment : counts symbols and builds the read-only query index;
+ * @param job : the job to initialize;
+ * @param env : the loading environment, sections must be assigned;
+ * @param defs : the namespace to resolve undefined symbols against;
+ * @param queries : a list of symbols the executable may define; names are
+ * expected to be unique;
+ * @param exports : the query index's exports, one per query;
+ * @param winners : the query index's definers, one per query;
+ * @param buckets : the query index's buckets;
+ * @param nb_buckets : the number of buckets, must not be null;
+ * @param bloom : the query index's bloom filter;
+ * @param bloom_words : the number of bloom words, must be a power of 2;
+ * @return 0 if the job was initialized, or the loading error;
+ */
+u8 loader_symbols_job_init(
+	struct loader_symbols_job *job,
+	struct loading_env *env,
+	struct loader_namespace *defs,
+	struct loader_symbol *queries,
+	struct loader_export *exports,
+	usize *winners,
+	struct loader_export **buckets,
+	usize nb_buckets,
+	usize *bloom,
+	usize bloom_words
+);
+
+/**
+ * loader_symbols_job_split : splits the job's symbols in @nb_chunks chunks of
+ * equal size;
+ * @param job : the job to split;
+ * @param chunks : the chunks to initialize;
+ * @param nb_chunks : the number of chunks, must not be null;
+ */
+void loader_symbols_job_split(
+	struct loader_symbols_job *job,
+	struct loader_symbols_chunk *chunks,
+	usize nb_chunks
+);
+
+/**
+ * loader_assign_symbols_chunk : assigns all symbols of the chunk; can be
+ * executed concurrently with other chunks of the same job;
+ * @param chunk : the chunk to process;
+ */
+void loader_assign_symbols_chunk(struct loader_symbols_chunk *chunk);
+
+/**
+ * loader_symbols_job_complete : merges chunks results once all chunks have
+ * been processed; if no chunk failed, defines each query with the value of
+ * its lowest-index definer;
+ * @param job : the job to complete;
+ * @param chunks : the job's chunks;
+ * @param nb_chunks : the number of chunks;
+ * @return 0 if all chunks succeeded, the error of the first failing chunk
+ * otherwise;
+ */
+u16 loader_symbols_job_complete(
+	struct loader_symbols_job *job,
+	struct loader_symbols_chunk *chunks,
+	usize nb_chunks
+);
+
+/**
+ * loader_assign_symbols_par : splits the job in chunks, makes @run process
+ * them, and completes the job;
+ * @param job : the initialized job;
+ * @param chunks : the chunks storage;
+ * @param nb_chunks : the number of chunks, must not be null;
+ * @param run : a function that executes loader_assign_symbols_chunk on each
+ * provided chunk, on any number of workers, and returns once all chunks are
+ * processed;
+ * @param arg : the first argument to pass to @run;
+ * @return 0 if all symbols were assigned, the loading error otherwise;
+ */
+u16 loader_assign_symbols_par(
+	struct loader_symbols_job *job,
+	struct loader_symbols_chunk *chunks,
+	usize nb_chunks,
+	void (*run)(void *arg, struct loader_symbols_chunk *chunks, usize nb),
+	void *arg
+);
+
 /**
  * apply_reloaction_table : for each relocation in the environment, verifies
  * the relocation can be applied (symbol valid and defined), then calls the
@@ -153,4 +529,110 @@ u16 loader_assign_symbols(
 u8 rmld_apply_relocations(struct loading_env *env);
 
 
+/*
+ * Batch loading;
+ *
+ * A batch loads several modules at once : all images are laid out
+ * contiguously in a single arena, so that the caller can read them all with
+ * one vectored or asynchronous request, and each loading phase is executed
+ * on all modules before the next one starts, under a single error context;
+ */
+
+/*The alignment of module images in a batch arena;*/
+#define LOADER_BATCH_ALIGN 64
+
+/**
+ * A loader module describes one elf file of a batch;
+ */
+struct loader_module {
+
+	/*The size in bytes of the file; set by the caller;*/
+	usize m_size;
+
+	/*The symbols the module may define, 0 if none; set by the caller;*/
+	struct loader_symbol *m_queries;
+
+	/*The address of the module's image in the arena;*/
+	void *m_image;
+
+	/*The module's loading environment;*/
+	struct loading_env m_env;
+
+	/*The phase the module failed in, if any;*/
+	u8 m_phase;
+
+	/*The loading error of the module, 0 if none;*/
+	u16 m_error;
+
+};
+
+/**
+ * A loader batch references a set of modules and their arena;
+ */
+struct loader_batch {
+
+	/*The modules of the batch;*/
+	struct loader_module *b_modules;
+
+	/*The number of modules;*/
+	usize b_nb_modules;
+
+	/*The arena holding all images;*/
+	void *b_arena;
+
+	/*The size of the arena in bytes;*/
+	usize b_arena_size;
+
+};
+
+/**
+ * loader_batch_arena_size : determines the size of the arena required to
+ * hold all modules of a batch;
+ * @param modules : the modules, with their size initialized;
+ * @param nb_modules : the number of modules;
+ * @return the required arena size in bytes;
+ */
+usize loader_batch_arena_size(
+	struct loader_module *modules,
+	usize nb_modules
+);
+
+/**
+ * loader_batch_init : initializes the batch and lays all module images out
+ * contiguously in the arena, in the order of the module array; the caller
+ * must then read each file at its module's image address;
+ * @param batch : the batch to initialize;
+ * @param modules : the modules, with their size and queries initialized;
+ * @param nb_modules : the number of modules;
+ * @param arena : the arena, aligned on LOADER_BATCH_ALIGN;
+ * @param arena_size : the size of the arena in bytes;
+ * @return 0 if all modules were laid out, 1 if the arena is too small;
+ */
+u8 loader_batch_init(
+	struct loader_batch *batch,
+	struct loader_module *modules,
+	usize nb_modules,
+	void *arena,
+	usize arena_size
+);
+
+/**
+ * loader_batch_load : loads all modules of the batch, whose images must have
+ * been read in the arena; each phase is executed on all modules before the
+ * next one starts; a module that fails is marked with its phase and error,
+ * and skipped in next phases;
+ * @param batch : the batch to load;
+ * @param defs : a list of defined symbols, used if @ns is null;
+ * @param ns : a namespace to search for definitions, 0 if none;
+ * @param stats : the stats to update, 0 to disable instrumentation;
+ * @return the number of modules that failed to load;
+ */
+usize loader_batch_load(
+	struct loader_batch *batch,
+	struct loader_symbol *defs,
+	struct loader_namespace *ns,
+	struct loader_stats *stats
+);
+
+
 #endif /*KERNEL_TK_LOADER_H*/
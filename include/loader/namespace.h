@@ -0,0 +1,179 @@
+/*namespace.h - kerneltk - GPLV3, copyleft 2019 Raphael Outhier;*/
+
+#ifndef KERNEL_TK_NAMESPACE_H
+#define KERNEL_TK_NAMESPACE_H
+
+#include <types.h>
+
+/**
+ * A loader export describes one symbol definition that a namespace provides
+ * to loaded executables;
+ */
+struct loader_export {
+
+	/*The name of the symbol;*/
+	const char *e_name;
+
+	/*The address of the symbol;*/
+	void *e_addr;
+
+	/*The hash of the symbol's name, computed at table initialization;*/
+	u32 e_hash;
+
+	/*Exports that share the same bucket are referenced in a linked list;*/
+	struct loader_export *e_next;
+
+};
+
+/**
+ * An export table is a hashed set of exports, fronted by a GNU_HASH style
+ * bloom filter, so that most lookups of a symbol the table doesn't define
+ * are rejected after reading a single word;
+ * All storage is provided by the caller at initialization;
+ */
+struct loader_export_table {
+
+	/*Tables are stacked in a namespace, from the top layer to the bottom;*/
+	struct loader_export_table *t_next;
+
+	/*The bloom filter words; their number is a power of 2;*/
+	usize *t_bloom;
+
+	/*The mask to apply to a word index, equal to the number of words - 1;*/
+	usize t_bloom_mask;
+
+	/*The bucket array; each bucket references the head of its chain;*/
+	struct loader_export **t_buckets;
+
+	/*The number of buckets; must not be null;*/
+	usize t_nb_buckets;
+
+};
+
+/**
+ * A loader namespace is an ordered stack of export tables; a lookup walks
+ * the stack from the top layer to the bottom one, and the first layer that
+ * defines the symbol provides its value; a layer thus shadows every symbol
+ * of the same name in the layers below it;
+ * Within a single layer, the first export of the table in declaration order
+ * wins;
+ */
+struct loader_namespace {
+
+	/*The top layer of the stack, 0 if the namespace is empty;*/
+	struct loader_export_table *n_top;
+
+};
+
+/**
+ * Lookup probe counters, updated by lookups when provided, to measure the
+ * cost of symbol resolution;
+ */
+struct loader_probe_stats {
+
+	/*The number of lookups;*/
+	usize p_lookups;
+
+	/*The number of layers or list entries visited;*/
+	usize p_layers;
+
+	/*The number of layers that rejected the name with their bloom filter;*/
+	usize p_bloom_rejects;
+
+	/*The number of chain entries compared;*/
+	usize p_chain_probes;
+
+	/*The longest chain walk of a single lookup;*/
+	usize p_max_probes;
+
+};
+
+/*The shift applied to a hash to obtain the second bloom bit;*/
+#define LOADER_BLOOM_SHIFT 6
+
+/**
+ * loader_symbol_hash : computes the GNU_HASH hash of the provided name;
+ * @param name : the name to hash;
+ * @return the hash of @name;
+ */
+u32 loader_symbol_hash(const char *name);
+
+/**
+ * loader_export_table_init : hashes all exports, builds their bucket chains
+ * and fills the bloom filter;
+ * @param table : the table to initialize;
+ * @param exports : the array of exports to reference; names and addresses
+ * must be initialized;
+ * @param nb_exports : the number of exports in @exports;
+ * @param buckets : the bucket array, of @nb_buckets entries;
+ * @param nb_buckets : the number of buckets, must not be null;
+ * @param bloom : the bloom filter array, of @bloom_words entries;
+ * @param bloom_words : the number of bloom words, must be a power of 2;
+ * @return 0 if the table was initialized, 1 if a size was invalid;
+ */
+u8 loader_export_table_init(
+	struct loader_export_table *table,
+	struct loader_export *exports,
+	usize nb_exports,
+	struct loader_export **buckets,
+	usize nb_buckets,
+	usize *bloom,
+	usize bloom_words
+);
+
+/**
+ * loader_export_table_find : searches the table for an export of the
+ * provided name;
+ * @param table : the table to search;
+ * @param name : the name of the symbol;
+ * @param hash : the hash of @name;
+ * @param probes : probe counters to update, 0 if none;
+ * @return the matching export if any, 0 if none;
+ */
+struct loader_export *loader_export_table_find(
+	struct loader_export_table *table,
+	const char *name,
+	u32 hash,
+	struct loader_probe_stats *probes
+);
+
+/**
+ * loader_namespace_init : initializes an empty namespace;
+ * @param ns : the namespace to initialize;
+ */
+void loader_namespace_init(struct loader_namespace *ns);
+
+/**
+ * loader_namespace_push : pushes a table on the top of the namespace; its
+ * exports will shadow exports of the same name in all lower layers;
+ * @param ns : the namespace to update;
+ * @param table : the initialized table to push;
+ */
+void loader_namespace_push(
+	struct loader_namespace *ns,
+	struct loader_export_table *table
+);
+
+/**
+ * loader_namespace_pop : removes the top layer of the namespace;
+ * @param ns : the namespace to update;
+ * @return the removed layer, 0 if the namespace was empty;
+ */
+struct loader_export_table *loader_namespace_pop(struct loader_namespace *ns);
+
+/**
+ * loader_namespace_find : searches the namespace, from the top layer to the
+ * bottom one, for an export of the provided name;
+ * @param ns : the namespace to search;
+ * @param name : the name of the symbol;
+ * @param probes : probe counters to update, 0 if none;
+ * @return the first matching export if any, 0 if none;
+ */
+struct loader_export *loader_namespace_find(
+	struct loader_namespace *ns,
+	const char *name,
+	struct loader_probe_stats *probes
+);
+
+
+#endif /*KERNEL_TK_NAMESPACE_H*/
@@ -0,0 +1,53 @@
+/*barrier.h - kerneltk - GPLV3, copyleft 2019 Raphael Outhier;*/
+
+#ifndef KERNEL_TK_BARRIER_H
+#define KERNEL_TK_BARRIER_H
+
+#include "sched.h"
+
+/**
+ * A barrier stops arriving tasks until a fixed number of tasks arrived; the
+ * last arrival resumes all stopped tasks at once and starts a new phase;
+ */
+struct sched_barrier {
+
+	/*The primitive that stops arrived tasks;*/
+	struct sprim b_prim;
+
+	/*The number of tasks that must arrive to complete a phase;*/
+	usize b_nb_parties;
+
+	/*The number of tasks arrived in the current phase;*/
+	usize b_nb_arrived;
+
+	/*The number of completed phases;*/
+	usize b_phase;
+
+};
+
+
+/**
+ * sched_barrier_ctor : constructs the barrier and registers it to the
+ * provided process;
+ * @param barrier : the barrier to construct;
+ * @param prc : the process to register the barrier to;
+ * @param nb_parties : the number of tasks that complete a phase, not null;
+ */
+void sched_barrier_ctor(
+		struct sched_barrier *barrier,
+		struct sprocess *prc,
+		usize nb_parties
+);
+
+/**
+ * sched_barrier_wait : reports the arrival of the thread's task; if it
+ * completes the phase, all stopped tasks are resumed and the task continues;
+ * if not, the task is stopped and a new one is assigned to the thread;
+ * @param barrier : the barrier to arrive at;
+ * @param thread : the thread executing the arriving task;
+ * @return 1 if the task completed the phase, 0 if it was stopped;
+ */
+u8 sched_barrier_wait(struct sched_barrier *barrier, struct sthread *thread);
+
+
+#endif /*KERNEL_TK_BARRIER_H*/
@@ -0,0 +1,65 @@
+/*cond.h - kerneltk - GPLV3, copyleft 2019 Raphael Outhier;*/
+
+#ifndef KERNEL_TK_COND_H
+#define KERNEL_TK_COND_H
+
+#include "mutex.h"
+
+/**
+ * A condition variable stops tasks until it is signaled; it is associated with
+ * a mutex, that waiting tasks must own, and that is released when they wait;
+ * A signaled task must take the mutex again; if the mutex is locked, the task
+ * is transferred to the mutex's stopped list instead of being resumed, so
+ * that a broadcast resumes at most one task, the others being resumed one by
+ * one when the mutex is unlocked;
+ */
+struct sched_cond {
+
+	/*The primitive that stops waiting tasks;*/
+	struct sprim c_prim;
+
+	/*The associated mutex;*/
+	struct sched_mutex *c_mutex;
+
+};
+
+
+/**
+ * sched_cond_ctor : constructs the condition variable, associates it with the
+ * mutex and registers it to the provided process;
+ * @param cond : the condition variable to construct;
+ * @param prc : the process to register the condition variable to;
+ * @param mutex : the mutex to associate, registered to the same process;
+ */
+void sched_cond_ctor(
+		struct sched_cond *cond,
+		struct sprocess *prc,
+		struct sched_mutex *mutex
+);
+
+/**
+ * sched_cond_wait : unlocks the associated mutex, stops the thread's task and
+ * assigns a new one to the thread; once resumed, the task must lock the mutex;
+ * @param cond : the condition variable to wait for;
+ * @param thread : the thread executing the task that must wait;
+ * @return 0 if the task waits, the error of sched_mutex_unlock if the mutex
+ * could not be unlocked;
+ */
+err_t sched_cond_wait(struct sched_cond *cond, struct sthread *thread);
+
+/**
+ * sched_cond_signal : wakes the first waiting task if any;
+ * @param cond : the condition variable to signal;
+ * @return 1 if a task was woken, 0 if none was waiting;
+ */
+u8 sched_cond_signal(struct sched_cond *cond);
+
+/**
+ * sched_cond_broadcast : wakes all waiting tasks;
+ * @param cond : the condition variable to signal;
+ * @return the number of woken tasks;
+ */
+usize sched_cond_broadcast(struct sched_cond *cond);
+
+
+#endif /*KERNEL_TK_COND_H*/
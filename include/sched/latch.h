@@ -0,0 +1,67 @@
+/*latch.h - kerneltk - GPLV3, copyleft 2019 Raphael Outhier;*/
+
+#ifndef KERNEL_TK_LATCH_H
+#define KERNEL_TK_LATCH_H
+
+#include "sched.h"
+
+/**
+ * A latch stops waiting tasks until its count reaches zero; the count down
+ * that reaches zero resumes all stopped tasks at once; the latch then stays
+ * open;
+ */
+struct sched_latch {
+
+	/*The primitive that stops waiting tasks;*/
+	struct sprim l_prim;
+
+	/*The number of count downs before the latch opens;*/
+	usize l_count;
+
+};
+
+
+/**
+ * sched_latch_ctor : constructs the latch and registers it to the provided
+ * process;
+ * @param latch : the latch to construct;
+ * @param prc : the process to register the latch to;
+ * @param count : the number of count downs before the latch opens;
+ */
+void sched_latch_ctor(
+		struct sched_latch *latch,
+		struct sprocess *prc,
+		usize count
+);
+
+/**
+ * sched_latch_count_down : decreases the count of the latch; if it reaches
+ * zero, all waiting tasks are resumed at once;
+ * @param latch : the latch to count down;
+ * @param nb : the number of count downs;
+ * @return 1 if the latch is open, 0 if not;
+ */
+u8 sched_latch_count_down(struct sched_latch *latch, usize nb);
+
+/**
+ * sched_latch_wait : if the latch is not open, stops the thread's task and
+ * assigns a new one to the thread;
+ * @param latch : the latch to wait for;
+ * @param thread : the thread executing the task that must wait;
+ * @return 1 if the latch is open, 0 if the task was stopped;
+ */
+u8 sched_latch_wait(struct sched_latch *latch, struct sthread *thread);
+
+/**
+ * sched_latch_is_open : determines whether the latch is open;
+ * @param latch : the latch to check;
+ * @return 1 if the latch is open, 0 if not;
+ */
+static __inline__ u8 sched_latch_is_open(struct sched_latch *latch) {
+
+	return (u8) (latch->l_count == 0);
+
+}
+
+
+#endif /*KERNEL_TK_LATCH_H*/
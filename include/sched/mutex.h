@@ -5,11 +5,43 @@
 
 #include "sched.h"
 
+/*The bounds and the initial value of the adaptive spin limit, in polls;*/
+#define SCHED_MUTEX_SPIN_MIN 16
+#define SCHED_MUTEX_SPIN_MAX 8192
+#define SCHED_MUTEX_SPIN_INIT 256
+
+/*The maximal number of idle iterations between two polls;*/
+#define SCHED_MUTEX_BACKOFF_MAX 64
+
+/*The owner word's contention bit; set if tasks may be stopped by the mutex;*/
+#define SCHED_MUTEX_CONTENDED ((usize) 1)
+
+/**
+ * A mutex's owner word references its owner, and its contention bit is set if
+ * tasks may be stopped by its primitive; while the bit is clear, the mutex is
+ * locked and unlocked with a single compare and swap, without the process
+ * lock, and its owner is not overridden; the first task that must be stopped
+ * sets the bit, and makes the primitive override the owner;
+ */
 struct sched_mutex {
 
 	/*A scheduler primitive;*/
 	struct sprim m_prim;
 
+	/*The owner word : the owner's address, or'ed with the contention bit;*/
+	volatile usize m_owner;
+
+	/*The number of polls after which an adaptive lock stops spinning; tends
+	 * to twice the average number of polls of successful spins, and is halved
+	 * at each failed spin;*/
+	usize m_spin_limit;
+
+	/*The number of adaptive locks that acquired the mutex by spinning;*/
+	usize m_nb_spin_acquired;
+
+	/*The number of adaptive locks that stopped their task;*/
+	usize m_nb_parked;
+
 };
 
 
@@ -21,6 +53,24 @@ struct sched_mutex {
  */
 void sched_mutex_ctor(struct sched_mutex *mutex, struct sprocess *prc);
 
+/**
+ * sched_mutex_set_ceiling : enables the immediate ceiling mode of the mutex;
+ * its owner is raised to the ceiling when it locks it, instead of inheriting
+ * the priorities of stopped tasks; ceiling mutexes must be unlocked in the
+ * reverse order of their locking;
+ * @param mutex : the unlocked mutex to update;
+ * @param ceiling : the ceiling, at least the priority of any task that may
+ * lock the mutex;
+ */
+static __inline__ void sched_mutex_set_ceiling(
+		struct sched_mutex *mutex,
+		usize ceiling
+) {
+
+	primitive_set_ceiling(&mutex->m_prim, ceiling);
+
+}
+
 /**
  * sched_mutex_lock : if the mutex is unlocked, locks it and registers the
  * thread's task as the owner of the mutex; if the mutex is locked, stops
@@ -39,6 +89,22 @@ void sched_mutex_lock(struct sched_mutex *mutex, struct sthread *thread);
  */
 u8 sched_mutex_lock_nb(struct sched_mutex *mutex, struct sthread *thread);
 
+/**
+ * sched_mutex_lock_adaptive : locks the mutex's process and attempts to lock
+ * the mutex; while the mutex's owner is executed by another thread, the
+ * process is unlocked and the thread spins with an exponential backoff, at
+ * most for the mutex's spin limit, before retrying; if the mutex can't be
+ * acquired, the task is stopped as by sched_mutex_lock; the process is
+ * unlocked on return; must be called with no lock held, between commits;
+ * @param mutex : the mutex to lock;
+ * @param thread : the thread executing the task that must lock the mutex;
+ * @return 1 if the mutex was locked, 0 if the task was stopped;
+ */
+u8 sched_mutex_lock_adaptive(
+		struct sched_mutex *mutex,
+		struct sthread *thread
+);
+
 /**
  * sched_mutex_is_locked : determines whether the mutex is locked or not;
  * the result is purely indicative;
@@ -47,20 +113,53 @@ u8 sched_mutex_lock_nb(struct sched_mutex *mutex, struct sthread *thread);
  */
 static __inline__ u8 sched_mutex_is_locked(struct sched_mutex *mutex) {
 
-	return (u8) (mutex->m_prim.p_nb_owning_tasks != 0);
+	return (u8) ((mutex->m_owner & ~SCHED_MUTEX_CONTENDED) != 0);
 
 }
 
+/**
+ * sched_mutex_contend : sets the contention bit of the mutex, so that its next
+ * unlock takes the process lock and resumes stopped tasks; if the mutex is
+ * locked and was not contended, its primitive overrides the owner;
+ * must be called before tasks are stopped by, or transferred to, the mutex's
+ * primitive;
+ * @param mutex : the mutex to update;
+ * @return 1 if the mutex is locked, 0 if not;
+ */
+u8 sched_mutex_contend(struct sched_mutex *mutex);
+
+/**
+ * sched_mutex_lock_fast : locks the mutex with a single compare and swap if it
+ * is unlocked and not contended; if not, locks the mutex's process and falls
+ * back to sched_mutex_lock; must be called with no lock held, between commits;
+ * @param mutex : the mutex to lock;
+ * @param thread : the thread executing the task that must lock the mutex;
+ * @return 1 if the mutex was locked, 0 if the task was stopped;
+ */
+u8 sched_mutex_lock_fast(struct sched_mutex *mutex, struct sthread *thread);
+
 /**
  * sched_mutex_unlock : if the mutex is locked, release its owner, and if any,
  * picks one stopped task and select it as the new owner;
  * @param mutex : the mutex to unlock;
  * @param thread : the thread executing the task that must unlock the mutex;
  * @return 0 if the mutex has been unlocked, 1 if it was already unlocked,
- *  2 if the thread's task didn't own the mutex, and 3 if an ownership
- *  release error occurred;
+ *  2 if the thread's task didn't own the mutex;
  */
 err_t sched_mutex_unlock(struct sched_mutex *mutex, struct sthread *thread);
 
+/**
+ * sched_mutex_unlock_fast : unlocks the mutex with a single compare and swap if
+ * it is not contended; if not, locks the mutex's process and falls back to
+ * sched_mutex_unlock; must be called with no lock held, between commits;
+ * @param mutex : the mutex to unlock;
+ * @param thread : the thread executing the task that must unlock the mutex;
+ * @return the error codes of sched_mutex_unlock;
+ */
+err_t sched_mutex_unlock_fast(
+		struct sched_mutex *mutex,
+		struct sthread *thread
+);
+
 
 #endif /*KERNEL_TK_MUTEX_H*/
@@ -0,0 +1,79 @@
+/*prio.h - kerneltk - GPLV3, copyleft 2019 Raphael Outhier;*/
+
+#ifndef KERNEL_TK_PRIO_H
+#define KERNEL_TK_PRIO_H
+
+#include "sched.h"
+
+/*The number of priority levels; must be a multiple of 32, at most 1024;*/
+#define SCHED_PRIO_NB_LEVELS 256
+
+/*The number of bits in a bitmap word;*/
+#define SCHED_PRIO_WORD_BITS 32
+
+/*The number of words of the level bitmap;*/
+#define SCHED_PRIO_NB_WORDS (SCHED_PRIO_NB_LEVELS / SCHED_PRIO_WORD_BITS)
+
+/*The default affinity window;*/
+#define SCHED_PRIO_AFFINITY_WINDOW 4
+
+/**
+ * The priority policy is a reference implementation of the scheduler
+ * operations; tasks waiting for a thread are queued in one FIFO run queue per
+ * priority level, and a two-level bitmap references non-empty levels, so that
+ * the most urgent task is found with two find-first-set operations;
+ * Tasks assigned to a thread are not queued; they are queued back when their
+ * thread is reassigned at commit close, after the tasks of the same level,
+ * which gives a round-robin order within a level;
+ * Tasks are queued at the level of their effective priority, so that
+ * overridden tasks inherit the priority of the tasks they block; effective
+ * priorities above the last level are scheduled in the last level;
+ * At commit close, the set of tasks to execute is the set of most urgent
+ * tasks; a task of this set is assigned its last thread if the thread's task
+ * distance is lower than the affinity window, so that warm tasks do not
+ * migrate; other tasks are assigned the remaining threads;
+ */
+struct sched_prio {
+
+	/*The operations, referenced by the scheduler;*/
+	struct sched_ops p_ops;
+
+	/*The summary word; bit i is set if the word i of the bitmap is not null;*/
+	u32 p_summary;
+
+	/*The level bitmap; bit j of word i is set if the level 32i + j is not
+	 * empty;*/
+	u32 p_bitmap[SCHED_PRIO_NB_WORDS];
+
+	/*Run queues, one per priority level;*/
+	struct dlist p_queues[SCHED_PRIO_NB_LEVELS];
+
+	/*The number of queued tasks;*/
+	usize p_nb_queued;
+
+	/*The maximal task distance under which a task is kept on its last
+	 * thread; 0 disables affinity;*/
+	usize p_affinity_window;
+
+	/*The number of tasks assigned a different thread than their last one;*/
+	usize p_nb_migrations;
+
+};
+
+/**
+ * sched_prio_ctor : initializes the policy and installs its operations in the
+ * scheduler; must be called before any task is registered;
+ * @param policy : the policy to initialize;
+ * @param sched : the scheduler to install the policy in;
+ */
+void sched_prio_ctor(struct sched_prio *policy, struct scheduler *sched);
+
+/**
+ * sched_prio_top : returns the most urgent queued task without dequeuing it;
+ * @param policy : the policy to query;
+ * @return the most urgent queued task, 0 if no task is queued;
+ */
+struct stask *sched_prio_top(struct sched_prio *policy);
+
+
+#endif /*KERNEL_TK_PRIO_H*/
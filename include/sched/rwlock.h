@@ -0,0 +1,135 @@
+/*rwlock.h - kerneltk - GPLV3, copyleft 2019 Raphael Outhier;*/
+
+#ifndef KERNEL_TK_RWLOCK_H
+#define KERNEL_TK_RWLOCK_H
+
+#include "sched.h"
+
+/**
+ * A reader-writer lock admits either one writer or several readers;
+ * Writers are stopped by a writers primitive, and readers by a readers
+ * primitive; both override the writer owning the lock;
+ * Each reader owns a reader slot, a primitive that overrides it and inherits
+ * the priority of the writers primitive, so that a stopped writer overrides
+ * all readers; the number of concurrent readers is the number of slots;
+ * If writers are preferred, readers are stopped while writers wait, and a
+ * released lock is given to writers first; if not, waiting readers are
+ * resumed first;
+ */
+struct sched_rwlock {
+
+	/*The primitive that stops writers;*/
+	struct sprim r_writers;
+
+	/*The primitive that stops readers;*/
+	struct sprim r_readers;
+
+	/*The reader slots, provided by the user;*/
+	struct sprim *r_slots;
+
+	/*The number of reader slots;*/
+	usize r_nb_slots;
+
+	/*The number of readers owning the lock;*/
+	usize r_nb_readers;
+
+	/*The writer owning the lock, 0 if none;*/
+	struct stask *r_writer;
+
+	/*If set, writers are preferred to readers;*/
+	u8 r_prefer_writers;
+
+};
+
+
+/**
+ * sched_rwlock_ctor : constructs the lock and registers its primitives to the
+ * provided process;
+ * @param rwlock : the lock to construct;
+ * @param prc : the process to register the lock to;
+ * @param slots : the reader slots;
+ * @param nb_slots : the number of reader slots, not null;
+ * @param prefer_writers : 1 if writers are preferred, 0 if readers are;
+ */
+void sched_rwlock_ctor(
+		struct sched_rwlock *rwlock,
+		struct sprocess *prc,
+		struct sprim *slots,
+		usize nb_slots,
+		u8 prefer_writers
+);
+
+/**
+ * sched_rwlock_read_lock : if the lock can be read, takes a reader slot for
+ * the thread's task; if not, stops the task and assigns a new one to the
+ * thread;
+ * @param rwlock : the lock to read-lock;
+ * @param thread : the thread executing the task that must read-lock;
+ */
+void sched_rwlock_read_lock(
+		struct sched_rwlock *rwlock,
+		struct sthread *thread
+);
+
+/**
+ * sched_rwlock_read_lock_nb : non blocking read-lock function;
+ * @param rwlock : the lock to read-lock;
+ * @param thread : the thread executing the task that must read-lock;
+ * @return 1 if the locking succeeds, 0 if not;
+ */
+u8 sched_rwlock_read_lock_nb(
+		struct sched_rwlock *rwlock,
+		struct sthread *thread
+);
+
+/**
+ * sched_rwlock_read_unlock : releases the reader slot of the thread's task,
+ * and resumes the tasks that may take the lock;
+ * @param rwlock : the lock to read-unlock;
+ * @param thread : the thread executing the task that must read-unlock;
+ * @return 0 if the lock has been read-unlocked, 1 if the task was not a
+ * reader, and 2 if an ownership release error occurred;
+ */
+err_t sched_rwlock_read_unlock(
+		struct sched_rwlock *rwlock,
+		struct sthread *thread
+);
+
+/**
+ * sched_rwlock_write_lock : if the lock is free, makes the thread's task its
+ * writer; if not, stops the task and assigns a new one to the thread;
+ * @param rwlock : the lock to write-lock;
+ * @param thread : the thread executing the task that must write-lock;
+ */
+void sched_rwlock_write_lock(
+		struct sched_rwlock *rwlock,
+		struct sthread *thread
+);
+
+/**
+ * sched_rwlock_write_lock_nb : non blocking write-lock function;
+ * @param rwlock : the lock to write-lock;
+ * @param thread : the thread executing the task that must write-lock;
+ * @return 1 if the locking succeeds, 0 if not;
+ */
+u8 sched_rwlock_write_lock_nb(
+		struct sched_rwlock *rwlock,
+		struct sthread *thread
+);
+
+/**
+ * sched_rwlock_write_unlock : releases the writer of the lock, and resumes
+ * the tasks that may take the lock;
+ * @param rwlock : the lock to write-unlock;
+ * @param thread : the thread executing the task that must write-unlock;
+ * @return 0 if the lock has been write-unlocked, 1 if it was not
+ * write-locked, 2 if the thread's task was not the writer, and 3 if an
+ * ownership release error occurred;
+ */
+err_t sched_rwlock_write_unlock(
+		struct sched_rwlock *rwlock,
+		struct sthread *thread
+);
+
+
+#endif /*KERNEL_TK_RWLOCK_H*/
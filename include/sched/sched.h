@@ -12,6 +12,7 @@ struct scheduler;
 struct sprocess;
 struct sprim;
 struct sthread;
+struct sched_deque;
 
 
 /*TODO GENERAL DOCUMENTATION;*
@@ -54,6 +55,9 @@ struct stask {
 	/*The status of the task;*/
 	enum sched_status t_status;
 
+	/*Task flags;*/
+	u8 t_flags;
+
 	/*Active tasks are referenced by the scheduler in a linked list;*/
 	struct dlist t_sched_list;
 
@@ -97,6 +101,10 @@ struct stask {
 	/*The list of overriding synchronization primitives the task owns;*/
 	struct dlist t_overriders;
 
+	/*The root of the pairing heap of overriding primitives, ordered by
+	 * priority; the root has the highest priority; 0 if none;*/
+	struct sprim *t_overriders_heap;
+
 	/*
 	 * Owner thread;
 	 */
@@ -107,6 +115,55 @@ struct stask {
 	/*The list of tasks stopped executed by the same thread;*/
 	struct dlist t_history;
 
+	/*The number of task switches of the thread when it was last assigned
+	 * the task;*/
+	usize t_thread_stamp;
+
+	/*
+	 * Scheduling;
+	 */
+
+	/*The base priority of the task, set before registration; the higher
+	 * the value, the more urgent the task;*/
+	usize t_priority;
+
+	/*The effective priority of the task, the maximum of its base priority,
+	 * of its ceiling and of the priorities of its overriders; updated at
+	 * commit close, and when the ceiling changes;*/
+	usize t_effective;
+
+	/*The highest ceiling of the ceiling primitives the task owns, 0 if
+	 * none;*/
+	usize t_ceiling;
+
+	/*Tasks marked updated are referenced by the scheduler in a linked list;*/
+	struct dlist t_dirty;
+
+	/*Tasks waiting for a thread are referenced in the implementation's run
+	 * queues;*/
+	struct dlist t_run_list;
+
+	/*The deque the task is queued in, 0 if none;*/
+	struct sched_deque *t_deque;
+
+	/*Tasks whose activity changed without the scheduler being updated are
+	 * referenced in the journal of their process;*/
+	struct dlist t_journal;
+
+	/*
+	 * Posted resume;
+	 */
+
+	/*Set while a resume of the task is posted;*/
+	volatile u8 t_posted;
+
+	/*The primitive the posted resume expects the task to be stopped by;*/
+	struct sprim *t_post_prim;
+
+	/*Tasks whose resume is posted are referenced in the scheduler's posted
+	 * stack;*/
+	struct stask *t_post_next;
+
 };
 
 
@@ -114,6 +171,22 @@ struct stask {
 * flag was reset;*/
 #define STASK_STATUS_UPDATED ((u8) (1 << 1))
 
+/*If set, the task is referenced in its process's journal;*/
+#define STASK_STATUS_JOURNALED ((u8) (1 << 2))
+
+/*If set, the journaled task is still in the scheduler's active list;*/
+#define STASK_STATUS_LISTED ((u8) (1 << 3))
+
+/**
+ * task_set_priority : updates the base priority of the task, and marks it
+ * updated; its effective priority, and the ones of the tasks it overrides, are
+ * recomputed at the next commit close, or when the process is unlocked if
+ * that commit could not lock it;
+ * @param task : the registered task to update;
+ * @param priority : the new base priority;
+ */
+void task_set_priority(struct stask *task, usize priority);
+
 /*-------------------------------------------------------- scheduler primitive*/
 
 /**
@@ -163,12 +236,65 @@ struct sprim {
 	/*The list of synchronization primitives overriding the same task;*/
 	struct dlist p_overriders;
 
+	/*The first child of the primitive in the overriders heap;*/
+	struct sprim *p_heap_child;
+
+	/*The next sibling of the primitive in the overriders heap;*/
+	struct sprim *p_heap_next;
+
+	/*The previous sibling of the primitive in the overriders heap, or its
+	 * parent if it is the first child;*/
+	struct sprim *p_heap_prev;
+
+	/*
+	 * Priority;
+	 */
+
+	/*The priority of the primitive, as determined by s_prim_get_prio, or the
+	 * one of its source if higher; updated at commit close;*/
+	usize p_priority;
+
+	/*The primitive whose priority is inherited if any;*/
+	struct sprim *p_source;
+
+	/*The list of primitives inheriting our priority;*/
+	struct dlist p_inheritors;
+
+	/*Primitives inheriting the priority of the same source are referenced in
+	 * a linked list;*/
+	struct dlist p_inherit_list;
+
+	/*Primitives marked updated are referenced by the scheduler in a linked
+	 * list;*/
+	struct dlist p_dirty;
+
+	/*
+	 * Ceiling;
+	 */
+
+	/*The ceiling, if the ceiling mode is enabled;*/
+	usize p_ceiling;
+
+	/*The task that took the primitive in ceiling mode, 0 if none;*/
+	struct stask *p_ceiling_owner;
+
+	/*The ceiling of the owner before it took the primitive;*/
+	usize p_saved_ceiling;
+
 };
 
 /*If set, the overriding tree of the primitive has been modified since this
 * flag was reset;*/
 #define SCHED_PRIM_STATUS_UPDATED ((u8) (1 << 0))
 
+/*If set, stopped tasks are ordered by decreasing effective priority, tasks of
+* equal priority in stop order; if not, stopped tasks are in stop order;*/
+#define SCHED_PRIM_STATUS_ORDERED ((u8) (1 << 1))
+
+/*If set, the primitive raises its owner to its ceiling, instead of
+* overriding it;*/
+#define SCHED_PRIM_STATUS_CEILING ((u8) (1 << 2))
+
 /**
  * sched_prim_init : resets all fields of the provided primitive;
  * @param prim : the primitive to reset;
@@ -176,6 +302,68 @@ struct sprim {
 void sched_prim_reset(struct sprim *prim);
 
 
+/*------------------------------------------------------------- scheduler lock*/
+
+/**
+ * The scheduler lock, and process locks, are MCS queue locks; each waiter
+ * queues a node and spins on its own flag, that its predecessor clears when it
+ * unlocks, so that the lock is handed off in arrival order, with one cache
+ * line transfer;
+ * Locks are taken in the following order : a process lock, then the scheduler
+ * lock;
+ * - the lock of a process protects its tasks and primitives : ownerships,
+ *   overrides, stopped lists and priority marks; it must be held by callers of
+ *   primitive and process functions, between commits, and by callers of the
+ *   commit functions that update a process, taken before the scheduler lock;
+ * - the scheduler lock protects the active list, threads, and the policy; it
+ *   must be held by callers of scheduler functions, and during commits; process
+ *   functions that activate or deactivate tasks, or report priorities, take it
+ *   internally with the process's node, unless the holder of the process lock
+ *   already holds it;
+ * As commits hold the scheduler lock, they only attempt to lock processes; the
+ * posted resumes, journal and priority marks of a process are applied at
+ * commit open and close if its lock can be taken at once; if not, the process
+ * is marked deferred, and the holder of its lock applies them when it unlocks
+ * it, with the scheduler locked; a process must thus be unlocked after the
+ * scheduler;
+ */
+
+/**
+ * A scheduler lock node : the queue entry of a waiter, or of the holder;
+ */
+struct sched_lock_node {
+
+	/*The next waiter, 0 if none;*/
+	struct sched_lock_node *volatile n_next;
+
+	/*Set while the waiter must spin;*/
+	volatile u8 n_waiting;
+
+};
+
+struct sched_lock {
+
+	/*The last queued node, 0 if the lock is free;*/
+	struct sched_lock_node *volatile l_tail;
+
+	/*The node of the holder;*/
+	struct sched_lock_node *l_holder;
+
+	/*The node queued by non-blocking acquisitions; the queue is empty when
+	 * they succeed, so that the node is never used twice;*/
+	struct sched_lock_node l_try_node;
+
+	/*The number of acquisitions;*/
+	usize l_nb_acquired;
+
+	/*The number of blocking acquisitions that found the lock held;*/
+	usize l_nb_contended;
+
+	/*The number of failed non-blocking acquisitions;*/
+	volatile usize l_nb_failed;
+
+};
+
 /*-------------------------------------------------------------- sched process*/
 
 /**
@@ -211,6 +399,36 @@ struct sprocess {
 	/*The synchronization primitive used to stop the whole process;*/
 	struct sprim p_prim;
 
+	/*The lock of the process's tasks and primitives;*/
+	struct sched_lock p_lock;
+
+	/*The node queued by the holder of the process lock when it waits for the
+	 * scheduler lock;*/
+	struct sched_lock_node p_sched_node;
+
+	/*Set while the holder of the process lock also holds the scheduler lock,
+	 * so that process functions don't lock it again;*/
+	u8 p_sched_held;
+
+	/*Set by a commit that could not lock the process; the holder of the
+	 * process lock then applies the work of the commit for the process when
+	 * it unlocks it;*/
+	volatile u8 p_deferred;
+
+	/*Tasks of the process marked updated since the last commit close;*/
+	struct dlist p_dirty_tasks;
+
+	/*Primitives of the process marked updated since the last commit close;*/
+	struct dlist p_dirty_prims;
+
+	/*Set while the process is locked by a thread in journal mode; activity
+	 * changes are then journaled, instead of updating the scheduler at once;*/
+	u8 p_journaling;
+
+	/*The tasks of the process whose activity changed in journal mode since
+	 * they were last merged;*/
+	struct dlist p_journal;
+
 };
 
 /*----------------------------------------------------------- scheduler thread*/
@@ -240,8 +458,35 @@ struct sthread {
 	/*The number of tasks in the history;*/
 	usize t_history_size;
 
+	/*The number of times the thread was assigned a different task;*/
+	usize t_nb_switches;
+
+	/*The node queued by the thread when it waits for the scheduler lock;*/
+	struct sched_lock_node t_lock_node;
+
+	/*The node queued by the thread when it waits for a process lock;*/
+	struct sched_lock_node t_process_node;
+
 };
 
+/**
+ * sched_task_distance : determines the number of task switches made by the
+ * last thread of the task since it was assigned the task; the lower the
+ * distance, the more of the task's footprint is likely to be still cached by
+ * the thread;
+ * @param task : the task to evaluate;
+ * @return the distance, (usize) -1 if the task has no last thread;
+ */
+static __inline__ usize sched_task_distance(struct stask *task) {
+
+	/*If the task has no last thread, its footprint is not cached;*/
+	if (!task->t_thread)
+		return (usize) -1;
+
+	return task->t_thread->t_nb_switches - task->t_thread_stamp;
+
+}
+
 /*------------------------------------------------------------------ scheduler*/
 
 struct sched_ops {
@@ -275,13 +520,22 @@ struct sched_ops {
 			struct stask *task
 	);
 
+	/*Called when several tasks of a primitive have been activated at once;
+	 * tasks are linked by their t_stopped field; if null, s_resumed is called
+	 * for each task;*/
+	void (*s_resumed_all)(
+			struct scheduler *sched,
+			struct dlist *tasks
+	);
+
 
 	/*
 	 * Scheduling;
 	 */
 
 	/* Update priorities of all tasks according to the priority function and 
-	 * dependencies between tasks;*/
+	 * dependencies between tasks; called at commit close, after effective
+	 * priorities of updated tasks have been recomputed and reported;*/
 	void (*s_schedule)(struct scheduler *sched);
 
 	/*Assign a task to each thread, according to the priority order;*/
@@ -295,7 +549,8 @@ struct sched_ops {
 
 
 	/*
-	 * Synchronization primitives;
+	 * Synchronization primitives; these hooks are called with the lock of the
+	 * primitive's process held, and the scheduler lock possibly not held;
 	 */
 
 	/*Report that a task has taken the ownership of a primitive;*/
@@ -314,7 +569,7 @@ struct sched_ops {
 
 
 	/*
-	 * Task priorities;
+	 * Task priorities; these hooks are called with the scheduler lock held;
 	 */
 
 	/*Notify the scheduler that the priority of a task has been updated;*/
@@ -341,7 +596,7 @@ struct sched_ops {
 struct scheduler {
 
 	/*Lock;*/
-	struct arch_spinlock s_lock;
+	struct sched_lock s_lock;
 	
 	/*Operations;*/
 	struct sched_ops *s_ops;
@@ -383,21 +638,119 @@ struct scheduler {
 	/*The number of threads;*/
 	usize s_nb_threads;
 
+	/*The maximal number of tasks in a thread's history, 0 if unbounded;
+	 * older tasks are forgotten; set with sched_set_history_limit;*/
+	usize s_history_limit;
+
+	/*
+	 * Priorities;
+	 */
+
+	/*The number of effective priority changes reported to the
+	 * implementation;*/
+	usize s_nb_priority_updates;
+
+	/*
+	 * Journals;
+	 */
+
+	/*If set, threads that lock a process with process_lock_thread journal
+	 * the activity changes they make;*/
+	u8 s_journaled;
+
+	/*The number of journaled tasks merged at commit closes;*/
+	usize s_nb_journaled;
+
+	/*
+	 * Posted resumes;
+	 */
+
+	/*The stack of tasks whose resume was posted, the last posted first;
+	 * pushed without lock, and taken as a whole by drains;*/
+	struct stask *volatile s_posted;
+
+	/*The number of posted resumes that resumed their task;*/
+	volatile usize s_nb_posted_resumed;
 
 };
 
-/*TODO CTOR DTOR*/
+/**
+ * sched_ctor : resets all fields and lists of the scheduler, and its lock,
+ * except its operations, that must be initialized by the caller;
+ * @param sched : the scheduler to construct;
+ */
+void sched_ctor(struct scheduler *sched);
 
 /*------------------------------------------------------------ access barriers*/
 
 /**
  * sched_lock : attempts to locks the scheduler;
- * This function must be called before any operation is made on the scheduler;
+ * This function must be called before any operation is made on the scheduler,
+ * and before a commit is opened;
  * @param sched : the scheduler to lock;
- * @return 0 if the lock succeeded, 1 if the scheduler was already locked;
+ * @return 1 if the lock succeeded, 0 if the scheduler was already locked;
  */
 u8 sched_lock(struct scheduler *sched);
 
+/**
+ * sched_lock_wait : locks the scheduler, waiting in the lock's queue until
+ * the previous holders unlocked it;
+ * @param sched : the scheduler to lock;
+ * @param node : the caller's queue node, unused until the scheduler is
+ * unlocked;
+ */
+void sched_lock_wait(struct scheduler *sched, struct sched_lock_node *node);
+
+/**
+ * sched_lock_thread : locks the scheduler, waiting in the lock's queue with
+ * the thread's node;
+ * @param thread : the registered thread that must lock its scheduler;
+ */
+static __inline__ void sched_lock_thread(struct sthread *thread) {
+
+	sched_lock_wait(thread->t_sched, &thread->t_lock_node);
+
+}
+
+/**
+ * process_lock_wait : locks the process, waiting in the lock's queue until
+ * the previous holders unlocked it; must be called with the scheduler
+ * unlocked;
+ * @param prc : the process to lock;
+ * @param node : the caller's queue node, unused until the process is unlocked;
+ */
+void process_lock_wait(struct sprocess *prc, struct sched_lock_node *node);
+
+/**
+ * process_lock_thread : locks the process, waiting in the lock's queue with
+ * the thread's process node; if the scheduler is in journal mode, the
+ * activity changes made until the process is unlocked are recorded in the
+ * process's journal;
+ * @param prc : the process to lock;
+ * @param thread : the thread that must lock the process;
+ */
+static __inline__ void process_lock_thread(
+		struct sprocess *prc,
+		struct sthread *thread
+) {
+
+	process_lock_wait(prc, &thread->t_process_node);
+
+	/*In journal mode, activity changes are recorded in the process's
+	 * journal;*/
+	prc->p_journaling = thread->t_sched->s_journaled;
+
+}
+
+/**
+ * process_unlock : unlocks the process; if a commit could not lock the
+ * process, its posted resumes, journal and priority marks are applied first,
+ * with the scheduler locked; the lock is handed off to the first waiter if
+ * any; must be called with the scheduler unlocked;
+ * @param prc : the process to unlock;
+ */
+void process_unlock(struct sprocess *prc);
+
 /**
  * sched_unlock : unlocks the scheduler; aborts if the scheduler is
  * unlocked;
@@ -423,7 +776,7 @@ void sched_register_process(struct scheduler *sched, struct sprocess *prc);
 
 /**
  * sched_register_process : reactivates all tasks stopped by the process
- * primitive;
+ * primitive; the process must have been locked before the scheduler;
  * Aborts if the process is not stopped;
  * @param sched : the scheduler to update;
  * @param prc : the process to register;
@@ -431,8 +784,10 @@ void sched_register_process(struct scheduler *sched, struct sprocess *prc);
 void sched_resume_process(struct sprocess *prc);
 
 /**
- * sched_open_commit : opens a new commit for the provided scheduler;
- * commit functions will be authorised after;
+ * sched_open_commit : opens a new commit for the provided scheduler, and
+ * makes the posted resumes of the processes whose lock is free; others are
+ * posted again, and made when their process is unlocked; commit functions
+ * will be authorised after;
  * Aborts if a commit is already opened;
  * @param sched : the scheduler to open a commit in;
  */
@@ -455,14 +810,16 @@ void sched_unregister_thread(struct sthread *thread);
  * sched_unregister_process : removes any task registered to the process from
  * the scheduler list and unregisters the process from its scheduler;
  * all tasks and primitives can be considered unregistered, even if links
- * are not explicitly reset;
+ * are not explicitly reset; the process must have been locked before the
+ * scheduler;
  * @param prc : the process to unregister;
  */
 void sched_unregister_process(struct sprocess *prc);
 
 /**
  * sched_pause_process : stops all active tasks registered to the process,
- * relatively to the process's synchronization primitive;
+ * relatively to the process's synchronization primitive; the process must
+ * have been locked before the scheduler;
  * Aborts if the
  * @param prc : the process to stop;
  */
@@ -475,6 +832,63 @@ void sched_pause_process(struct sprocess *prc);
  */
 void sched_close_commit(struct scheduler *sched);
 
+/**
+ * sched_set_journaled : enables or disables the journal mode; in journal
+ * mode, the activity changes made by a thread that locked the process with
+ * process_lock_thread are recorded in the process's journal, without the
+ * scheduler lock; at commit close, the journal of each process whose lock is
+ * free is merged in one pass, where the active list and the implementation
+ * are updated; resumed tasks are thus not scheduled before a commit close;
+ * the task executed by a thread is never journaled : when it is stopped, the
+ * thread locks the scheduler to deactivate it and to be assigned a new task;
+ * @param sched : the scheduler to update;
+ * @param journaled : 1 to enable the journal mode, 0 to disable it;
+ */
+void sched_set_journaled(struct scheduler *sched, u8 journaled);
+
+/**
+ * sched_set_history_limit : updates the maximal number of tasks in a thread's
+ * history; longer histories forget their oldest tasks at once; the scheduler
+ * must be locked;
+ * @param sched : the scheduler to update;
+ * @param limit : the new limit, 0 for unbounded histories;
+ */
+void sched_set_history_limit(struct scheduler *sched, usize limit);
+
+/**
+ * sched_post_resume : posts a resume of the task, that will be made by the
+ * next drain if the task is still stopped by the primitive; takes no lock and
+ * never waits, so that it can be called from interrupt handlers and I/O
+ * completions; a task is posted at most once at a time, and must not be
+ * unregistered while its resume is posted;
+ * @param task : the registered task to resume;
+ * @param prim : the primitive the task is expected to be stopped by;
+ * @return 1 if the resume was posted, 0 if a resume was already posted;
+ */
+u8 sched_post_resume(struct stask *task, struct sprim *prim);
+
+/**
+ * sched_drain_posted : makes the posted resumes of the scheduler in their
+ * posting order, locking the process of each task with the thread's node;
+ * posted resumes are also made when a commit is opened, for the processes
+ * whose lock is free; must be called with no lock held, between commits;
+ * @param thread : the registered thread that drains the posted resumes;
+ * @return the number of resumed tasks;
+ */
+usize sched_drain_posted(struct sthread *thread);
+
+/*----------------------------------------------------------- thread functions*/
+
+/**
+ * thread_assign_task : assigns the provided task to the provided thread;
+ * If the task is already assigned to a different thread that the new one,
+ * the task is unregistered from it before; if @task is null, the thread is
+ * marked inactive;
+ * @param thread : the thread to assign the task to;
+ * @param task : the task that must be assigned to the thread;
+ */
+void thread_assign_task(struct sthread *thread, struct stask *task);
+
 /*---------------------------------------------------------- process functions*/
 
 /**
@@ -543,7 +957,8 @@ err_t primitive_release_ownership(struct sprim *prim, struct stask *task);
  * primitive_override_task : mark the task overridden by the primitive;
  * The primitive is inserted in the list of the task's overriding primitives;
  * If the primitive already has an owner, its ownership is released before;
- * The task must be active;
+ * The task must be registered; it may be stopped by another primitive, as
+ * overrides can be set up lazily, once the primitive is contended;
  * @param prim : the primitive that must override the task;
  * @param task : the task the primitive must override;
  */
@@ -566,6 +981,29 @@ void primitive_unoverride_task(struct sprim *prim);
  */
 void primitive_resume_task(struct stask *task);
 
+/**
+ * primitive_resume_n : resumes the first tasks stopped by the primitive in one
+ * pass; the resumed part of the stopped list is detached at once, the
+ * primitive is marked updated once, and the implementation is notified once
+ * if it supports it;
+ * @param prim : the primitive whose tasks must be resumed;
+ * @param nb_tasks : the maximal number of tasks to resume;
+ * @return the number of resumed tasks;
+ */
+usize primitive_resume_n(struct sprim *prim, usize nb_tasks);
+
+/**
+ * primitive_resume_all : resumes all tasks stopped by the primitive in one
+ * pass;
+ * @param prim : the primitive whose tasks must be resumed;
+ * @return the number of resumed tasks;
+ */
+static __inline__ usize primitive_resume_all(struct sprim *prim) {
+
+	return primitive_resume_n(prim, (usize) -1);
+
+}
+
 /**
  * primitive_stop_thread : stops the task being executed by the thread, and
  * assign a new task to it;
@@ -575,4 +1013,79 @@ void primitive_resume_task(struct stask *task);
  */
 void primitive_stop_thread(struct sprim *prim, struct sthread *thread);
 
+/**
+ * primitive_transfer_task : moves the stopped task to the stopped list of the
+ * primitive, without resuming it; both primitives are marked updated;
+ * Aborts if the task is not stopped;
+ * @param prim : the primitive that must stop the task;
+ * @param task : the stopped task to transfer;
+ */
+void primitive_transfer_task(struct sprim *prim, struct stask *task);
+
+/**
+ * primitive_inherit : makes the primitive inherit the priority of the source,
+ * so that the task it overrides inherits the priority of the tasks stopped by
+ * the source; several primitives can inherit the same source, which lets one
+ * primitive's stopped tasks override several tasks; sources must not form a
+ * cycle;
+ * @param prim : the primitive to update;
+ * @param source : the primitive to inherit the priority of, 0 to stop
+ * inheriting;
+ */
+void primitive_inherit(struct sprim *prim, struct sprim *source);
+
+/**
+ * primitive_set_ceiling : enables the immediate ceiling mode of the primitive;
+ * tasks that take a ceiling primitive are raised to its ceiling at once, with
+ * no propagation in the tasks-primitives tree; must be called after
+ * registration, while the primitive is not taken;
+ * @param prim : the primitive to update;
+ * @param ceiling : the ceiling, at least the priority of any task that may
+ * take the primitive;
+ */
+void primitive_set_ceiling(struct sprim *prim, usize ceiling);
+
+/**
+ * primitive_ceiling_take : raises the task to the ceiling of the primitive,
+ * and references it as the primitive's ceiling owner; the task must be
+ * active;
+ * @param prim : the ceiling primitive taken by the task;
+ * @param task : the task that takes the primitive;
+ */
+void primitive_ceiling_take(struct sprim *prim, struct stask *task);
+
+/**
+ * primitive_ceiling_release : restores the ceiling the task had before it
+ * took the primitive; ceiling primitives must be released in the reverse
+ * order of their takings;
+ * @param prim : the ceiling primitive released by its ceiling owner;
+ */
+void primitive_ceiling_release(struct sprim *prim);
+
+/**
+ * primitive_set_ordered : selects the order of the primitive's stopped list;
+ * if ordered, stopped tasks are kept ordered by decreasing effective priority,
+ * and repositioned when their effective priority is recomputed; must be called
+ * after registration, while the primitive stopped no task;
+ * @param prim : the primitive to update;
+ * @param ordered : 1 for the priority order, 0 for the stop order;
+ */
+void primitive_set_ordered(struct sprim *prim, u8 ordered);
+
+/**
+ * primitive_first_stopped : returns the first task of the primitive's stopped
+ * list, which is the one that must be resumed first;
+ * @param prim : the primitive to query;
+ * @return the first stopped task, 0 if the primitive stopped no task;
+ */
+static __inline__ struct stask *primitive_first_stopped(struct sprim *prim) {
+
+	/*If the primitive stopped no task, return 0;*/
+	if (dlist_empty(&prim->p_stopped))
+		return 0;
+
+	return container_of(prim->p_stopped.next, struct stask, t_stopped);
+
+}
+
 #endif /*KERNELTK_SCHED_H*/
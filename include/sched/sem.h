@@ -13,6 +13,9 @@ struct sched_sem {
 	/*The maximal number of takings;*/
 	usize s_nb_owners;
 
+	/*The holder slots if priority inheritance is enabled, 0 if not;*/
+	struct sprim *s_slots;
+
 };
 
 
@@ -28,6 +31,16 @@ void sched_sem_ctor(
 		struct sprocess *prc
 );
 
+/**
+ * sched_sem_inherit : enables priority inheritance; each taking is
+ * associated with a holder slot, a primitive that overrides the holder and
+ * inherits the priority of the semaphore, so that stopped tasks override all
+ * holders; must be called after construction, before any taking;
+ * @param sem : the semaphore to update;
+ * @param slots : the holder slots, as many as the maximal number of takings;
+ */
+void sched_sem_inherit(struct sched_sem *sem, struct sprim *slots);
+
 /**
  * sched_sem_take : if the semaphore's ownership can be taken once, it is taken
  * by the task executed by the provided thread; if not, the executed task is
@@ -70,5 +83,50 @@ static __inline__ u8 sched_sem_is_locked(struct sched_sem *sem) {
  */
 err_t sched_sem_release(struct sched_sem *sem, struct sthread *thread);
 
+/**
+ * sched_sem_take_n : if the semaphore's ownership can be taken the provided
+ * number of times, it is taken by the task executed by the provided thread;
+ * if not, the executed task is stopped and a new one is assigned to the
+ * thread;
+ * @param sem : the semaphore to take;
+ * @param nb_takings : the number of takings, at most the semaphore's limit;
+ * @param thread : the thread executing the task that must take;
+ */
+void sched_sem_take_n(
+		struct sched_sem *sem,
+		usize nb_takings,
+		struct sthread *thread
+);
+
+/**
+ * sched_sem_take_n_nb : non blocking multiple take function;
+ * @param sem : the semaphore to take;
+ * @param nb_takings : the number of takings;
+ * @param thread : the thread executing the task that must take;
+ * @return 1 if the takings succeed, 0 if not;
+ */
+u8 sched_sem_take_n_nb(
+		struct sched_sem *sem,
+		usize nb_takings,
+		struct sthread *thread
+);
+
+/**
+ * sched_sem_release_n : releases the provided number of ownerships of the
+ * semaphore, and resumes, in one pass, as many stopped tasks as the semaphore
+ * can now be taken times;
+ * @param sem : the semaphore to release;
+ * @param nb_takings : the number of ownerships to release;
+ * @param thread : the thread executing the task that should release its
+ * ownerships of the semaphore;
+ * @return 0 if the ownerships were successfully released, 1 if an ownership
+ * release error occurred;
+ */
+err_t sched_sem_release_n(
+		struct sched_sem *sem,
+		usize nb_takings,
+		struct sthread *thread
+);
+
 
 #endif /*KERNEL_TK_SEM_H*/
@@ -0,0 +1,124 @@
+/*steal.h - kerneltk - GPLV3, copyleft 2019 Raphael Outhier;*/
+
+#ifndef KERNEL_TK_STEAL_H
+#define KERNEL_TK_STEAL_H
+
+#include "sched.h"
+
+/**
+ * A scheduler deque is the local run queue of a thread; its owner pushes and
+ * pops tasks at the bottom, and other threads steal them at the top; deques
+ * are only accessed by the policy's operations, with the scheduler lock held,
+ * and need no synchronization of their own; stopped tasks are removed from
+ * their deque at once;
+ */
+struct sched_deque {
+
+	/*Queued tasks, linked by their run links, from the top to the bottom;*/
+	struct dlist d_tasks;
+
+	/*The number of queued tasks;*/
+	usize d_nb_tasks;
+
+};
+
+/**
+ * A steal thread is a scheduler thread with its local run queue; threads
+ * registered to a scheduler using the steal policy must be steal threads;
+ */
+struct steal_thread {
+
+	/*The scheduler thread;*/
+	struct sthread s_thread;
+
+	/*The local run queue;*/
+	struct sched_deque s_deque;
+
+	/*The number of tasks taken from the local run queue;*/
+	usize s_nb_pops;
+
+	/*The number of tasks stolen from other threads;*/
+	usize s_nb_steals;
+
+};
+
+/**
+ * The steal policy is an implementation of the scheduler operations where
+ * each thread takes tasks from its local deque, and steals from other
+ * threads when it is empty; tasks resumed or registered between commits are
+ * referenced in an injection list, that threads consume when no task can be
+ * stolen; at commit close, all threads are idle, and the policy rebalances
+ * the queues : running tasks are rotated to the top of their deque, and
+ * injected tasks are distributed, to their last thread if it is not
+ * overloaded, to the least loaded thread otherwise;
+ * This policy does not remove the scheduler lock from the stop and resume
+ * paths : the core calls all policy operations with the scheduler lock held,
+ * as it also protects the active list; deques keep tasks on their thread and
+ * balance the load of threads, but each assignment still takes the scheduler
+ * lock; in journal mode, resumes don't take it, but stops of executed tasks
+ * do;
+ */
+struct sched_steal {
+
+	/*The operations, referenced by the scheduler;*/
+	struct sched_ops s_ops;
+
+	/*Tasks resumed or registered since the last commit;*/
+	struct dlist s_inject;
+
+	/*The number of injected tasks;*/
+	usize s_nb_injected;
+
+	/*The number of deque entries and injected tasks at the last commit;*/
+	usize s_nb_queued;
+
+};
+
+/**
+ * sched_deque_init : initializes an empty deque;
+ * @param deque : the deque to initialize;
+ */
+void sched_deque_init(struct sched_deque *deque);
+
+/**
+ * sched_deque_push : pushes a task at the bottom of the deque;
+ * @param deque : the deque to update;
+ * @param task : the task to push, queued nowhere;
+ */
+void sched_deque_push(struct sched_deque *deque, struct stask *task);
+
+/**
+ * sched_deque_pop : removes the task at the bottom of the deque;
+ * @param deque : the deque to update;
+ * @return the removed task, 0 if the deque is empty;
+ */
+struct stask *sched_deque_pop(struct sched_deque *deque);
+
+/**
+ * sched_deque_steal : removes the task at the top of the deque;
+ * @param deque : the deque to update;
+ * @return the removed task, 0 if the deque is empty;
+ */
+struct stask *sched_deque_steal(struct sched_deque *deque);
+
+/**
+ * sched_steal_ctor : initializes the policy and installs its operations in
+ * the scheduler; must be called before any task or thread is registered;
+ * @param policy : the policy to initialize;
+ * @param sched : the scheduler to install the policy in;
+ */
+void sched_steal_ctor(struct sched_steal *policy, struct scheduler *sched);
+
+/**
+ * sched_steal_register_thread : initializes the thread's local run queue and
+ * registers the thread in the scheduler;
+ * @param sched : the scheduler to update;
+ * @param thread : the thread to register;
+ */
+void sched_steal_register_thread(
+		struct scheduler *sched,
+		struct steal_thread *thread
+);
+
+
+#endif /*KERNEL_TK_STEAL_H*/
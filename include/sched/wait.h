@@ -0,0 +1,104 @@
+/*wait.h - kerneltk - GPLV3, copyleft 2019 Raphael Outhier;*/
+
+#ifndef KERNEL_TK_WAIT_H
+#define KERNEL_TK_WAIT_H
+
+#include "sched.h"
+
+/**
+ * A wait queue stops the tasks waiting on one address; wait queues are pooled
+ * and bound to an address while tasks wait on it;
+ */
+struct sched_wait_queue {
+
+	/*The primitive that stops waiting tasks;*/
+	struct sprim w_prim;
+
+	/*The address tasks wait on, 0 if the queue is free;*/
+	volatile usize *w_addr;
+
+	/*Bound queues are referenced in their bucket's list, free ones in the
+	 * table's free list;*/
+	struct dlist w_list;
+
+};
+
+/**
+ * A wait table lets tasks wait on any word, without embedding a primitive in
+ * it; bound wait queues are referenced in a hashed array of buckets, and are
+ * taken from a pool when a task waits on a new address, and returned to it
+ * when no task waits on it anymore;
+ * A word's value must be modified before the tasks waiting on it are woken,
+ * and the table's process must be locked during both waits and wakes, so that
+ * no wake is missed;
+ */
+struct sched_waits {
+
+	/*The buckets, provided by the user;*/
+	struct dlist *w_buckets;
+
+	/*The number of buckets - 1; the number of buckets is a power of 2;*/
+	usize w_mask;
+
+	/*The list of free wait queues;*/
+	struct dlist w_free;
+
+	/*The number of free wait queues;*/
+	usize w_nb_free;
+
+};
+
+
+/**
+ * sched_waits_ctor : constructs the wait table, and registers the primitives
+ * of the pooled wait queues to the provided process;
+ * @param waits : the table to construct;
+ * @param prc : the process to register the wait queues to;
+ * @param buckets : the bucket array;
+ * @param nb_buckets : the number of buckets, must be a power of 2;
+ * @param queues : the wait queue pool;
+ * @param nb_queues : the number of wait queues;
+ * @return 0 if the table was constructed, 1 if the number of buckets was
+ * invalid;
+ */
+u8 sched_waits_ctor(
+		struct sched_waits *waits,
+		struct sprocess *prc,
+		struct dlist *buckets,
+		usize nb_buckets,
+		struct sched_wait_queue *queues,
+		usize nb_queues
+);
+
+/**
+ * sched_wait : if the word still has the expected value, stops the thread's
+ * task on the word's wait queue, and assigns a new task to the thread;
+ * @param waits : the wait table;
+ * @param addr : the address of the word to wait on;
+ * @param expected : the value the word must have for the task to wait;
+ * @param thread : the thread executing the task that must wait;
+ * @return 0 if the task was stopped, 1 if the word had another value, 2 if
+ * no wait queue was available;
+ */
+err_t sched_wait(
+		struct sched_waits *waits,
+		volatile usize *addr,
+		usize expected,
+		struct sthread *thread
+);
+
+/**
+ * sched_wake : resumes the first tasks waiting on the word;
+ * @param waits : the wait table;
+ * @param addr : the address of the word;
+ * @param nb_tasks : the maximal number of tasks to resume;
+ * @return the number of resumed tasks;
+ */
+usize sched_wake(
+		struct sched_waits *waits,
+		volatile usize *addr,
+		usize nb_tasks
+);
+
+
+#endif /*KERNEL_TK_WAIT_H*/
@@ -3,6 +3,8 @@
 
 #include <loader/loader.h>
 
+#include <loader/namespace.h>
+
 #include <except.h>
 
 #include <string.h>
@@ -47,6 +49,49 @@ static __inline__ void loading_error(struct loading_env *env, u8 err_type) {
 	throw_error(env->r_error_ctx, err_type);
 }
 
+/**
+ * stats_phase_start : if stats are enabled, reads the cycle counter;
+ * @param env : the loading environment;
+ * @return the current cycle count if stats are enabled, 0 if not;
+ */
+static __inline__ u64 stats_phase_start(struct loading_env *env)
+{
+	return (env->r_stats) ? loader_cycles() : 0;
+}
+
+/**
+ * stats_phase_end : if stats are enabled, accumulates the cycles spent in
+ * @phase since @start;
+ * @param env : the loading environment;
+ * @param phase : the index of the phase;
+ * @param start : the cycle count at the phase start;
+ */
+static __inline__ void stats_phase_end(
+	struct loading_env *env,
+	u8 phase,
+	u64 start
+)
+{
+	if (env->r_stats)
+		env->r_stats->s_cycles[phase] += loader_cycles() - start;
+}
+
+/**
+ * stats_touch : if stats are enabled, accumulates the size of a table walked
+ * by the loader;
+ * @param env : the loading environment;
+ * @param table : the table that is walked;
+ */
+static __inline__ void stats_touch(
+	struct loading_env *env,
+	struct elf_table *table
+)
+{
+	if (env->r_stats)
+		env->r_stats->s_bytes_touched +=
+			(usize) table->t_end - (usize) table->t_start;
+}
+
 /*---------------------------------------------------------------- loader init*/
 
 /**
@@ -59,11 +104,36 @@ void loader_init(
 	struct loading_env *env,
 	void *ram_start
 )
+{
+	loader_init_stats(env, ram_start, 0);
+}
+
+/**
+ * loader_init_stats : initializes the loading environment for the provided
+ * elf file, and makes all loading phases update the provided stats;
+ * Stats are not reset, so that they can be accumulated over several loads;
+ * @param env : the environment to initialize;
+ * @param ram_start : the address of the file's first byte in RAM;
+ * @param stats : the stats to update, 0 to disable instrumentation;
+ */
+void loader_init_stats(
+	struct loading_env *env,
+	void *ram_start,
+	struct loader_stats *stats
+)
 {
 	
 	struct elf64_hdr *hdr;
 	u8 *shtable;
 	usize shentry_size;
+	u64 start;
+	
+	/*Initialize stats and error context;*/
+	env->r_stats = stats;
+	env->r_error_ctx = 0;
+	
+	/*Start the phase;*/
+	start = stats_phase_start(env);
 	
 	/*Initialize the elf header;*/
 	env->r_hdr = hdr = ram_start;
@@ -79,6 +149,9 @@ void loader_init(
 	env->r_shtable.t_end =
 		ptr_sum_byte_offset(shtable, shentry_size * hdr->e_shnum);
 	
+	/*End the phase;*/
+	stats_phase_end(env, LOADER_PHASE_INIT, start);
+	
 }
 
 /*-------------------------------------------------------- sections assignment*/
@@ -98,11 +171,18 @@ u8 loader_assign_sections(
 	void *hdr;
 	struct elf_table shtable;
 	struct elf64_shdr *shdr;
+	u64 start;
+	
+	/*Start the phase;*/
+	start = stats_phase_start(env);
 	
 	/*Fetch vars;*/
 	hdr = env->r_hdr;
 	shtable = env->r_shtable;
 	
+	/*Report the section table walk;*/
+	stats_touch(env, &shtable);
+	
 	/*Iterate over the section table :*/
 	TABLE_ITERATE(shtable, shdr) {
 		
@@ -110,8 +190,10 @@ u8 loader_assign_sections(
 		u64 offset;
 		
 		/*If the section is of type nobits, with non-null size, fail;*/
-		if ((shdr->sh_type == SHT_NOBITS) && (shdr->sh_size != 0))
+		if ((shdr->sh_type == SHT_NOBITS) && (shdr->sh_size != 0)) {
+			stats_phase_end(env, LOADER_PHASE_LAYOUT, start);
 			return LOADER_ERROR_NON_EMPTY_NOBITS_SECTION;
+		}
 		
 		/*Fetch the offset and size of the section;*/
 		offset = shdr->sh_offset;
@@ -124,6 +206,9 @@ u8 loader_assign_sections(
 		
 	}
 	
+	/*End the phase;*/
+	stats_phase_end(env, LOADER_PHASE_LAYOUT, start);
+	
 	/*Complete;*/
 	return 0;
 	
@@ -251,12 +336,24 @@ static void __get_section_table(
 
 /*---------------------------------------------------------- symbol definition*/
 
-/*Search a symbol table for a symbol definition;*/
-void *sym_def_find(struct loader_symbol *defs, const char *name)
+/*Search a symbol table for a symbol definition; update probes if provided;*/
+void *sym_def_find(
+	struct loader_symbol *defs,
+	const char *name,
+	struct loader_probe_stats *probes
+)
 {
 	
+	/*Report the lookup if required;*/
+	if (probes)
+		probes->p_lookups++;
+	
 	while (defs) {
 		
+		/*Report the entry visit if required;*/
+		if (probes)
+			probes->p_layers++;
+		
 		/*If undefined or names do not match, skip;*/
 		if ((!defs->s_defined) || (str_cmp(name, defs->s_name) != 0)) {
 			
@@ -275,6 +372,41 @@ void *sym_def_find(struct loader_symbol *defs, const char *name)
 	
 }
 
+/**
+ * sym_resolve : searches the provided definition source for a symbol; if a
+ * namespace is provided, it is searched instead of the definition list;
+ * @param env : the loading environment;
+ * @param defs : the list of definitions, used if @ns is null;
+ * @param ns : the namespace to search, 0 if none;
+ * @param name : the name of the symbol to resolve;
+ * @return the address of the definition if found, 0 if not;
+ */
+static void *sym_resolve(
+	struct loading_env *env,
+	struct loader_symbol *defs,
+	struct loader_namespace *ns,
+	const char *name
+)
+{
+	
+	struct loader_export *export;
+	struct loader_probe_stats *probes;
+	
+	/*Fetch probe counters if stats are enabled;*/
+	probes = (env->r_stats) ? &env->r_stats->s_probes : 0;
+	
+	/*If no namespace is provided, search the definition list;*/
+	if (!ns)
+		return sym_def_find(defs, name, probes);
+	
+	/*Search the namespace's layers;*/
+	export = loader_namespace_find(ns, name, probes);
+	
+	/*Return the first matching export's address if any;*/
+	return (export) ? export->e_addr : 0;
+	
+}
+
 /*--------------------------------------------------------- symbols assignment*/
 
 /**
@@ -325,6 +457,58 @@ static void update_symbol_address(
 	
 }
 
+/**
+ * assign_symbol : if the symbol is defined, updates its address; if not,
+ * searches the external definitions for its value, or resets it to 0;
+ * @param env : the loading environment;
+ * @param sym : the symbol to assign;
+ * @param s_name : the name of the symbol;
+ * @param definitions : a list of defined symbols, used if @ns is null;
+ * @param ns : a namespace to search instead of @definitions, 0 if none;
+ */
+static void assign_symbol(
+	struct loading_env *env,
+	struct elf64_sym *sym,
+	const char *s_name,
+	struct loader_symbol *definitions,
+	struct loader_namespace *ns
+)
+{
+	
+	struct loader_stats *stats;
+	
+	/*Fetch the stats;*/
+	stats = env->r_stats;
+	
+	/*If the symbol is undefined :*/
+	if (sym->sy_shndx == SHN_UNDEF) {
+		
+		/*If a definition exists, update the value;
+		 * if not, set the symbol's value to 0;*/
+		sym->sy_value = (u64) sym_resolve(env, definitions, ns, s_name);
+		
+		/*Report the resolution of named symbols;*/
+		if (stats && *s_name) {
+			if (sym->sy_value) {
+				stats->s_syms_external++;
+			} else {
+				stats->s_syms_unresolved++;
+			}
+		}
+		
+	} else {
+		
+		/*If the symbol is defined, update its value;*/
+		update_symbol_address(env, sym);
+		
+		/*Report the internal definition;*/
+		if (stats)
+			stats->s_syms_internal++;
+		
+	}
+	
+}
+
 /**
  * assing_symbol_table : for each symbol in the symbol table :
  * - if the symbol is defined updates the symbol's address internally and
@@ -338,6 +522,7 @@ static void update_symbol_address(
  * @param definitions : a list of defined symbols, that are accessible to the
  * executable; if undefined symbols with matching names are found in the
  * executable, their value will be set to the value provided in the list;
+ * @param ns : a namespace to search instead of @definitions, 0 if none;
  * @param queries : a set of symbols the executable may define; if defined
  * symbols with matching names are found in the executable, the list will be
  * updated with the value of the symbol in the executable;
@@ -346,6 +531,7 @@ static void assing_symbol_table(
 	struct loading_env *env,
 	struct elf64_shdr *sym_table_header,
 	struct loader_symbol *definitions,
+	struct loader_namespace *ns,
 	struct loader_symbol *queries
 )
 {
@@ -355,6 +541,10 @@ static void assing_symbol_table(
 	u16 str_table_index;
 	struct elf_table str_table;
 	struct elf64_sym *sym;
+	struct loader_stats *stats;
+	
+	/*Fetch the stats;*/
+	stats = env->r_stats;
 	
 	/*Fetch the symbol table;*/
 	__section_header_to_table(env, sym_table_header, &symtable);
@@ -365,6 +555,10 @@ static void assing_symbol_table(
 	/*Fetch the string table;*/
 	__get_section_table(env, str_table_index, SHT_STRTAB, &str_table);
 	
+	/*Report both tables walks;*/
+	stats_touch(env, &symtable);
+	stats_touch(env, &str_table);
+	
 	/*Iterate over the symbol table;*/
 	TABLE_ITERATE(symtable, sym) {
 		
@@ -374,23 +568,8 @@ static void assing_symbol_table(
 		/*Fetch the name start;*/
 		s_name = __get_table_entry(env, &str_table, sym->sy_name);
 		
-		/*
-		 * Internal symbol definition;
-		 */
-		
-		/*If the symbol is undefined :*/
-		if (sym->sy_shndx == SHN_UNDEF) {
-			
-			/*If a definition exists, update the value;
-			 * if not, set the symbol's value to 0;*/
-			sym->sy_value = (u64) sym_def_find(definitions, s_name);
-			
-		} else {
-			
-			/*If the symbol is defined, update its value;*/
-			update_symbol_address(env, sym);
-			
-		}
+		/*Internal symbol definition;*/
+		assign_symbol(env, sym, s_name, definitions, ns);
 		
 		/*If the symbol's value is null, stop here;*/
 		if (!sym->sy_value) {
@@ -420,6 +599,10 @@ static void assing_symbol_table(
 			ext_sym->s_defined = 1;
 			ext_sym->s_addr = (void *) sym->sy_value;
 			
+			/*Report the query definition;*/
+			if (stats)
+				stats->s_syms_queried++;
+			
 			/*Stop here;*/
 			break;
 			
@@ -430,34 +613,65 @@ static void assing_symbol_table(
 }
 
 /**
- * loader_assign_symbols : for each symbol in the environment :
- * - if the symbol is defined updates the symbol's address internally and
- *   updated the list of symbol queries if required;
- * - if the symbol is not defined, search the list of external definitions
- *   for an eventual matching symbol;
- * It it possible that undefined symbols remain after the execution of this
- * function. Those will have their value assigned to 0;
+ * assign_symbol_tables : calls the symbol table assignment function for each
+ * symbol table in the environment; loading errors are thrown to the
+ * environment's error context;
  * @param env : the loading environment
- * @param definitions : a list of defined symbols, that are accessible to the
- * executable; if undefined symbols with matching names are found in the
- * executable, their value will be set to the value provided in the list;
- * @param queries : a set of symbols the executable may define; if defined
- * symbols with matching names are found in the executable, the list will be
- * updated with the value of the symbol in the executable;
- * @return 0 if all symbols had their value assigned, or, if a symbol table's
- * string table index was invalid (only source of error), the index of the
- * symbol table's section header; this error should stop the loading;
+ * @param defs : a list of defined symbols, used if @ns is null;
+ * @param ns : a namespace to search for definitions, 0 if none;
+ * @param undefs : a set of symbols the executable may define;
  */
-u16 loader_assign_symbols(
+static void assign_symbol_tables(
 	struct loading_env *env,
 	struct loader_symbol *defs,
+	struct loader_namespace *ns,
 	struct loader_symbol *undefs
 )
 {
 	
 	struct elf_table shtable;
 	struct elf64_shdr *sheader;
+	
+	/*Fetch section header table descriptor;*/
+	shtable = env->r_shtable;
+	
+	/*Iterate over the section table :*/
+	TABLE_ITERATE(shtable, sheader) {
+		
+		/*If the section holds a symbol table :*/
+		if (sheader->sh_type == SHT_SYMTAB) {
+			
+			/*Assign symbols in the symbol table;*/
+			assing_symbol_table(env, sheader, defs, ns, undefs);
+			
+		}
+		
+	}
+	
+}
+
+/**
+ * assign_symbols : calls the symbol table assignment function for each symbol
+ * table in the environment, catching loading errors;
+ * @param env : the loading environment
+ * @param defs : a list of defined symbols, used if @ns is null;
+ * @param ns : a namespace to search for definitions, 0 if none;
+ * @param undefs : a set of symbols the executable may define;
+ * @return 0 if all symbols had their value assigned, or the loading error;
+ */
+static u16 assign_symbols(
+	struct loading_env *env,
+	struct loader_symbol *defs,
+	struct loader_namespace *ns,
+	struct loader_symbol *undefs
+)
+{
+	
 	u8 error_id;
+	u64 start;
+	
+	/*Start the phase;*/
+	start = stats_phase_start(env);
 	
 	try(ctx, error_id) {
 			
@@ -465,21 +679,8 @@ u16 loader_assign_symbols(
 			/*Reset at exception exit, to avoid scope escapism;*/
 			env->r_error_ctx = &ctx;
 			
-			/*Fetch section header table descriptor;*/
-			shtable = env->r_shtable;
-			
-			/*Iterate over the section table :*/
-			TABLE_ITERATE(shtable, sheader) {
-				
-				/*If the section holds a symbol table :*/
-				if (sheader->sh_type == SHT_SYMTAB) {
-					
-					/*Assign symbols in the symbol table;*/
-					assing_symbol_table(env, sheader, defs, undefs);
-					
-				}
-				
-			}
+			/*Assign symbols of all symbol tables;*/
+			assign_symbol_tables(env, defs, ns, undefs);
 			
 		}
 	
@@ -488,84 +689,944 @@ u16 loader_assign_symbols(
 	/*Reset the internal error context to avoid scope escapism;*/
 	env->r_error_ctx = 0;
 	
+	/*End the phase;*/
+	stats_phase_end(env, LOADER_PHASE_SYMBOLS, start);
+	
 	/*Return the error id;*/
 	return error_id;
 	
 }
 
-/*--------------------------------------------------------------- relocations */
-
 /**
- * loader_apply_relocation : apply the relocation @rel_type to @rel_addr,
- * regarding symbol at @sym_addr and @addend; If the relocation fails to be
- * applied, the function stops throws the related error;
- * This function is processor-defined;
- * @param rel_addr : the address to apply the relocation to;
- * @param sym_addr : the address of the symbol the relocation concerns;
- * @param addend : the relocation addend, null if none;
- * @param rel_type : the relocation type;
- * @return 0 if the relocation was applied correctly, LOADER_ERROR_REL_BAD_TYPE
- * if bad relocation type, LOADER_ERROR_REL_VALUE_OVERFLOW if relocation value
- * overflow.
+ * loader_assign_symbols : for each symbol in the environment :
+ * - if the symbol is defined updates the symbol's address internally and
+ *   updated the list of symbol queries if required;
+ * - if the symbol is not defined, search the list of external definitions
+ *   for an eventual matching symbol;
+ * It it possible that undefined symbols remain after the execution of this
+ * function. Those will have their value assigned to 0;
+ * @param env : the loading environment
+ * @param definitions : a list of defined symbols, that are accessible to the
+ * executable; if undefined symbols with matching names are found in the
+ * executable, their value will be set to the value provided in the list;
+ * @param queries : a set of symbols the executable may define; if defined
+ * symbols with matching names are found in the executable, the list will be
+ * updated with the value of the symbol in the executable;
+ * @return 0 if all symbols had their value assigned, or, if a symbol table's
+ * string table index was invalid (only source of error), the index of the
+ * symbol table's section header; this error should stop the loading;
  */
-u8 loader_apply_relocation(
-	u64 rel_addr,
-	u64 sym_addr,
-	s64 addend,
-	u32 rel_type
-);
+u16 loader_assign_symbols(
+	struct loading_env *env,
+	struct loader_symbol *defs,
+	struct loader_symbol *undefs
+)
+{
+	return assign_symbols(env, defs, 0, undefs);
+}
 
 /**
- * apply_reloaction_table : for each relocation in the relocation table,
- * verifies the relocation can be applied (symbol valid and defined), then
- * calls the processor-defined function @loader_apply_relocation, to actually
- * apply the relocation. If a relocation fails to be applied, the function
- * stops throws the related error;
- * @param env : the relocation environment;
- * @param rel_table_hdr : the relocation table header;
+ * loader_assign_symbols_ns : same as loader_assign_symbols, except that
+ * undefined symbols are resolved against the layers of a namespace, the
+ * first layer from the top that defines a symbol providing its value;
+ * @param env : the loading environment
+ * @param ns : the namespace providing definitions;
+ * @param undefs : a set of symbols the executable may define;
+ * @return 0 if all symbols had their value assigned, or the loading error;
  */
-static void apply_reloaction_table(
+u16 loader_assign_symbols_ns(
 	struct loading_env *env,
-	struct elf64_shdr *rel_table_hdr
+	struct loader_namespace *ns,
+	struct loader_symbol *undefs
+)
+{
+	return assign_symbols(env, 0, ns, undefs);
+}
+
+/*------------------------------------------------------- profile-guided layout*/
+
+/**
+ * profile_entry_swap : swaps two profile entries;
+ */
+static __inline__ void profile_entry_swap(
+	struct loader_profile_entry *a,
+	struct loader_profile_entry *b
+)
+{
+	struct loader_profile_entry tmp = *a;
+	*a = *b;
+	*b = tmp;
+}
+
+/**
+ * profile_sift_down : restores the min-heap property of the entries heap
+ * from @root; the lightest entry is at the root;
+ * @param entries : the heap;
+ * @param root : the index to sift down;
+ * @param size : the number of entries in the heap;
+ */
+static void profile_sift_down(
+	struct loader_profile_entry *entries,
+	usize root,
+	usize size
 )
 {
 	
-	u8 explicit_addend;
-	struct elf_table reltable;
-	u16 symtbl_id;
-	
-	u16 rel_sect_id;
-	struct elf64_shdr *rel_sect_hdr;
-	u64 rel_sect_start;
-	
-	struct elf_table symtbl;
-	struct elf64_rela *rel;
+	usize child;
 	
+	while ((child = 2 * root + 1) < size) {
+		
+		/*Select the lightest child;*/
+		if ((child + 1 < size) &&
+			(entries[child + 1].p_weight < entries[child].p_weight))
+			child++;
+		
+		/*If the root is lighter than its children, complete;*/
+		if (entries[root].p_weight <= entries[child].p_weight)
+			return;
+		
+		profile_entry_swap(entries + root, entries + child);
+		root = child;
+		
+	}
 	
-	/*Determine whether an explicit addend is provided;*/
-	explicit_addend = (u8) (rel_table_hdr->sh_type == SHT_RELA);
+}
+
+/**
+ * loader_profile_init : sorts the profile's entries by decreasing weight and
+ * builds the index over their names;
+ * @param profile : the profile to initialize;
+ * @param entries : the profile entries;
+ * @param nb_entries : the number of entries;
+ * @param hot_threshold : the minimal weight of a hot section;
+ * @param exports : the index's exports, one per entry;
+ * @param buckets : the index's buckets;
+ * @param nb_buckets : the number of buckets, must not be null;
+ * @param bloom : the index's bloom filter;
+ * @param bloom_words : the number of bloom words, must be a power of 2;
+ * @return 0 if the profile was initialized, or the loading error;
+ */
+u8 loader_profile_init(
+	struct loader_profile *profile,
+	struct loader_profile_entry *entries,
+	usize nb_entries,
+	usize hot_threshold,
+	struct loader_export *exports,
+	struct loader_export **buckets,
+	usize nb_buckets,
+	usize *bloom,
+	usize bloom_words
+)
+{
 	
-	/*Fetch the relocation table;*/
-	__section_header_to_table(env, rel_table_hdr, &reltable);
+	usize id;
 	
-	/*Fetch the symbol table header identifier;*/
-	symtbl_id = (u16) rel_table_hdr->sh_link;
+	/*Sort entries by decreasing weight, with an in-place min-heap sort;*/
+	for (id = nb_entries / 2; id--;) {
+		profile_sift_down(entries, id, nb_entries);
+	}
+	for (id = nb_entries; id-- > 1;) {
+		profile_entry_swap(entries, entries + id);
+		profile_sift_down(entries, 0, id);
+	}
 	
-	/*Fetch the symbol table;*/
-	__get_section_table(env, symtbl_id, SHT_SYMTAB, &symtbl);
+	/*Initialize the profile;*/
+	profile->p_entries = entries;
+	profile->p_nb_entries = nb_entries;
+	profile->p_hot_threshold = hot_threshold;
 	
-	/*Fetch the index of the section to relocate;*/
-	rel_sect_id = (u16) rel_table_hdr->sh_info;
+	/*Reference each entry in the index;*/
+	for (id = 0; id < nb_entries; id++) {
+		exports[id].e_name = entries[id].p_name;
+		exports[id].e_addr = entries + id;
+	}
 	
-	/*Fetch the header of the section to relocate;*/
-	rel_sect_hdr = __get_section_header(env, rel_sect_id, SHT_PROGBITS);
+	/*Build the index;*/
+	if (loader_export_table_init(&profile->p_index, exports, nb_entries,
+		buckets, nb_buckets, bloom, bloom_words))
+		return LOADER_ERROR_BAD_INDEX_SIZE;
 	
-	/*Fetch the start and size of the section whose content will be changed;*/
-	rel_sect_start = rel_sect_hdr->sh_addr;
+	/*Complete;*/
+	return 0;
 	
-	/*Iterate over the relocation table;*/
-	TABLE_ITERATE(reltable, rel) {
-		u64 rel_addr;
+}
+
+/**
+ * section_is_text : determines whether a section holds executable code;
+ * @param shdr : the section header;
+ * @return 1 if the section is executable, 0 if not;
+ */
+static __inline__ u8 section_is_text(struct elf64_shdr *shdr)
+{
+	return (u8) ((shdr->sh_type == SHT_PROGBITS) &&
+		(shdr->sh_flags & SHF_EXECINSTR));
+}
+
+/**
+ * section_align : rounds @offset up to the alignment of a section;
+ * @param shdr : the section header;
+ * @param offset : the offset to align;
+ * @return the aligned offset;
+ */
+static __inline__ usize section_align(struct elf64_shdr *shdr, usize offset)
+{
+	
+	usize align;
+	
+	/*Null and unit alignments are ignored;*/
+	align = (usize) shdr->sh_addralign;
+	if (align <= 1)
+		return offset;
+	
+	return (offset + align - 1) & ~(align - 1);
+	
+}
+
+/**
+ * loader_text_size : determines the size of a region able to hold all
+ * executable sections of the environment;
+ * @param env : the loading environment;
+ * @return the size in bytes, alignment paddings included;
+ */
+usize loader_text_size(struct loading_env *env)
+{
+	
+	struct elf_table shtable;
+	struct elf64_shdr *shdr;
+	usize size;
+	
+	/*Fetch the section table descriptor;*/
+	shtable = env->r_shtable;
+	
+	/*Sum sizes of executable sections, with their worst padding;*/
+	size = 0;
+	TABLE_ITERATE(shtable, shdr) {
+		
+		if (!section_is_text(shdr))
+			continue;
+		
+		size += (usize) shdr->sh_size;
+		if (shdr->sh_addralign > 1)
+			size += (usize) shdr->sh_addralign - 1;
+		
+	}
+	
+	/*Complete;*/
+	return size;
+	
+}
+
+/**
+ * profile_find : searches the profile for an entry matching a section name,
+ * first by the full name, then by the function name if the section is named
+ * ".text.<function>";
+ * @param profile : the profile to search;
+ * @param name : the name of the section;
+ * @return the matching entry if any, 0 if none;
+ */
+static struct loader_profile_entry *profile_find(
+	struct loader_profile *profile,
+	const char *name
+)
+{
+	
+	struct loader_export *export;
+	const char *prefix;
+	
+	/*Search the full name;*/
+	export = loader_export_table_find(
+		&profile->p_index, name, loader_symbol_hash(name), 0
+	);
+	
+	/*If not found, search the name following a ".text." prefix;*/
+	if (!export) {
+		
+		for (prefix = ".text."; *prefix && (*prefix == *name); prefix++)
+			name++;
+		
+		if (!*prefix) {
+			export = loader_export_table_find(
+				&profile->p_index, name, loader_symbol_hash(name), 0
+			);
+		}
+		
+	}
+	
+	/*Return the entry if any;*/
+	return (export) ? export->e_addr : 0;
+	
+}
+
+/**
+ * place_section : copies a section at the next aligned offset of a region and
+ * updates the section's address; throws a loading error if the region is too
+ * small;
+ * @param env : the loading environment;
+ * @param shdr : the header of the section to place;
+ * @param region : the start of the region;
+ * @param offset : the current offset in the region, updated;
+ * @param region_size : the size of the region;
+ */
+static void place_section(
+	struct loading_env *env,
+	struct elf64_shdr *shdr,
+	u8 *region,
+	usize *offset,
+	usize region_size
+)
+{
+	
+	u8 *src;
+	u8 *dst;
+	usize start;
+	usize size;
+	
+	/*Determine the section's location;*/
+	start = section_align(shdr, *offset);
+	size = (usize) shdr->sh_size;
+	
+	/*If the region is too small, fail;*/
+	if ((start > region_size) || (size > region_size - start)) {
+		loading_error(env, LOADER_ERROR_REGION_TOO_SMALL);
+	}
+	
+	/*Copy the section;*/
+	src = (u8 *) shdr->sh_addr;
+	dst = region + start;
+	*offset = start + size;
+	while (size--) {
+		*(dst++) = *(src++);
+	}
+	
+	/*Update the section's address;*/
+	shdr->sh_addr = (u64) (region + start);
+	
+	/*Report the copy;*/
+	if (env->r_stats)
+		env->r_stats->s_bytes_touched += (usize) shdr->sh_size;
+	
+}
+
+/**
+ * loader_reorder_text : copies executable sections to the hot and cold
+ * regions according to the profile, and updates their addresses; must be
+ * called after loader_assign_sections, and before symbols assignment;
+ * @param env : the loading environment;
+ * @param profile : the initialized profile;
+ * @param hot : the start of the hot region;
+ * @param hot_size : the size of the hot region;
+ * @param cold : the start of the cold region;
+ * @param cold_size : the size of the cold region;
+ * @return 0 if all sections were placed, or the loading error;
+ */
+u8 loader_reorder_text(
+	struct loading_env *env,
+	struct loader_profile *profile,
+	void *hot,
+	usize hot_size,
+	void *cold,
+	usize cold_size
+)
+{
+	
+	struct elf_table shtable;
+	struct elf_table names;
+	struct elf64_shdr *shdr;
+	struct loader_profile_entry *entry;
+	usize hot_offset;
+	usize cold_offset;
+	usize id;
+	u16 section_id;
+	u8 error_id;
+	u64 start;
+	
+	/*Start the phase;*/
+	start = stats_phase_start(env);
+	
+	try(ctx, error_id) {
+			
+			/*Update the internal error context;*/
+			/*Reset at exception exit, to avoid scope escapism;*/
+			env->r_error_ctx = &ctx;
+			
+			/*Reset entries matches;*/
+			for (id = 0; id < profile->p_nb_entries; id++) {
+				profile->p_entries[id].p_section = 0;
+			}
+			
+			/*Fetch the section names table;*/
+			__get_section_table(
+				env, env->r_hdr->e_shstrndx, SHT_STRTAB, &names
+			);
+			
+			/*Fetch the section table descriptor;*/
+			shtable = env->r_shtable;
+			cold_offset = 0;
+			section_id = 0;
+			
+			/*Match executable sections, placing cold ones in file order;*/
+			TABLE_ITERATE(shtable, shdr) {
+				
+				if (section_is_text(shdr)) {
+					
+					/*Search the section's profile entry;*/
+					entry = profile_find(
+						profile, __get_table_entry(env, &names, shdr->sh_name)
+					);
+					
+					/*If the entry is hot, reference the section;*/
+					if (entry && (!entry->p_section) &&
+						(entry->p_weight >= profile->p_hot_threshold)) {
+						
+						entry->p_section = section_id;
+						
+					} else {
+						
+						/*If not, place the section in the cold region;*/
+						place_section(env, shdr, cold, &cold_offset, cold_size);
+						
+					}
+					
+				}
+				
+				section_id++;
+				
+			}
+			
+			/*Place hot sections in decreasing weight order;*/
+			hot_offset = 0;
+			for (id = 0; id < profile->p_nb_entries; id++) {
+				
+				section_id = profile->p_entries[id].p_section;
+				
+				if (section_id) {
+					shdr = __get_section_header(env, section_id, 0);
+					place_section(env, shdr, hot, &hot_offset, hot_size);
+				}
+				
+			}
+			
+		}
+	
+	try_end
+	
+	/*Reset the internal error context to avoid scope escapism;*/
+	env->r_error_ctx = 0;
+	
+	/*End the phase;*/
+	stats_phase_end(env, LOADER_PHASE_LAYOUT, start);
+	
+	/*Return the error id;*/
+	return error_id;
+	
+}
+
+/*-------------------------------------------------- parallel symbols assignment*/
+
+/**
+ * symbols_job_publish : if a query of the job matches the provided name, and
+ * if the symbol at @index precedes its current definer, makes it the
+ * query's definer; the lowest index always wins, whatever the order in which
+ * chunks are executed;
+ * @param job : the job the query index relates to;
+ * @param s_name : the name of the defined symbol;
+ * @param index : the global index of the defined symbol;
+ */
+static void symbols_job_publish(
+	struct loader_symbols_job *job,
+	const char *s_name,
+	usize index
+)
+{
+	
+	struct loader_export *export;
+	struct loader_symbol *query;
+	volatile usize *winner;
+	usize current;
+	
+	/*Search the query index; most names are rejected by the bloom filter;*/
+	export = loader_export_table_find(
+		&job->j_queries, s_name, loader_symbol_hash(s_name), 0
+	);
+	
+	/*If the name is not queried, complete;*/
+	if (!export)
+		return;
+	
+	/*If the query was defined before the job, it must not be updated;*/
+	query = export->e_addr;
+	if (query->s_defined)
+		return;
+	
+	/*Fetch the query's definer;*/
+	winner = job->j_winners + (export - job->j_query_exports);
+	
+	/*Lower the definer index until it is lower or equal to ours;*/
+	do {
+		
+		current = *winner;
+		
+		if (current <= index)
+			return;
+		
+	} while (!__sync_bool_compare_and_swap(winner, current, index));
+	
+}
+
+/**
+ * assign_symbol_range : assigns symbols of the symbol table whose global
+ * index is in [@first, @end[ and publishes their definitions to the job's
+ * queries;
+ * @param env : the chunk's loading environment;
+ * @param sym_table_header : the symbol table's section header;
+ * @param job : the job the chunk relates to;
+ * @param base : the global index of the table's first symbol;
+ * @param first : the global index of the first symbol to assign;
+ * @param end : the global index of the last symbol to assign's successor;
+ * @return the number of symbols in the table;
+ */
+static usize assign_symbol_range(
+	struct loading_env *env,
+	struct elf64_shdr *sym_table_header,
+	struct loader_symbols_job *job,
+	usize base,
+	usize first,
+	usize end
+)
+{
+	
+	struct elf_table symtable;
+	struct elf_table str_table;
+	struct elf64_sym *sym;
+	usize nb_syms;
+	usize index;
+	
+	/*Fetch the symbol and string tables;*/
+	__section_header_to_table(env, sym_table_header, &symtable);
+	__get_section_table(
+		env, (u16) sym_table_header->sh_link, SHT_STRTAB, &str_table
+	);
+	
+	/*Determine the number of symbols in the table;*/
+	nb_syms = sym_table_header->sh_size / symtable.t_bsize;
+	
+	/*Clamp the range to the table;*/
+	if (first < base)
+		first = base;
+	if (end > base + nb_syms)
+		end = base + nb_syms;
+	
+	/*Report the slice walk;*/
+	if ((first < end) && env->r_stats)
+		env->r_stats->s_bytes_touched += (end - first) * symtable.t_bsize;
+	
+	/*For each symbol in the range :*/
+	for (index = first; index < end; index++) {
+		
+		const char *s_name;
+		
+		/*Fetch the symbol and its name;*/
+		sym = __get_table_entry(env, &symtable, index - base);
+		s_name = __get_table_entry(env, &str_table, sym->sy_name);
+		
+		/*Resolve or update the symbol's value;*/
+		assign_symbol(env, sym, s_name, 0, job->j_defs);
+		
+		/*If the symbol has a value, publish it to queries;*/
+		if (sym->sy_value)
+			symbols_job_publish(job, s_name, index);
+		
+	}
+	
+	/*Complete;*/
+	return nb_syms;
+	
+}
+
+/**
+ * symbols_job_symbol : fetches the symbol at the provided global index;
+ * the index must have been assigned by a chunk of the job without error;
+ * @param env : the loading environment;
+ * @param index : the global index of the symbol;
+ * @return the symbol at @index;
+ */
+static struct elf64_sym *symbols_job_symbol(
+	struct loading_env *env,
+	usize index
+)
+{
+	
+	struct elf_table shtable;
+	struct elf64_shdr *sheader;
+	usize nb_syms;
+	
+	/*Fetch section header table descriptor;*/
+	shtable = env->r_shtable;
+	
+	/*Iterate over symbol tables until the index is reached;*/
+	TABLE_ITERATE(shtable, sheader) {
+		
+		if (sheader->sh_type != SHT_SYMTAB)
+			continue;
+		
+		nb_syms = sheader->sh_size / sheader->sh_entsize;
+		
+		if (index < nb_syms) {
+			return ptr_sum_byte_offset(env->r_hdr,
+				sheader->sh_offset + index * sheader->sh_entsize);
+		}
+		
+		index -= nb_syms;
+		
+	}
+	
+	/*Not reached for indices assigned by a chunk;*/
+	return 0;
+	
+}
+
+/**
+ * loader_symbols_job_init : prepares the parallel assignment of all symbols of
+ * the environment : counts symbols and builds the read-only query index;
+ * @param job : the job to initialize;
+ * @param env : the loading environment, sections must be assigned;
+ * @param defs : the namespace to resolve undefined symbols against;
+ * @param queries : a list of symbols the executable may define; names are
+ * expected to be unique;
+ * @param exports : the query index's exports, one per query;
+ * @param winners : the query index's definers, one per query;
+ * @param buckets : the query index's buckets;
+ * @param nb_buckets : the number of buckets, must not be null;
+ * @param bloom : the query index's bloom filter;
+ * @param bloom_words : the number of bloom words, must be a power of 2;
+ * @return 0 if the job was initialized, or the loading error;
+ */
+u8 loader_symbols_job_init(
+	struct loader_symbols_job *job,
+	struct loading_env *env,
+	struct loader_namespace *defs,
+	struct loader_symbol *queries,
+	struct loader_export *exports,
+	usize *winners,
+	struct loader_export **buckets,
+	usize nb_buckets,
+	usize *bloom,
+	usize bloom_words
+)
+{
+	
+	struct elf_table shtable;
+	struct elf64_shdr *sheader;
+	usize nb_queries;
+	
+	/*Initialize the job;*/
+	job->j_env = env;
+	job->j_defs = defs;
+	job->j_query_exports = exports;
+	job->j_winners = winners;
+	job->j_nb_symbols = 0;
+	
+	/*Count symbols of all symbol tables;*/
+	shtable = env->r_shtable;
+	TABLE_ITERATE(shtable, sheader) {
+		
+		if (sheader->sh_type != SHT_SYMTAB)
+			continue;
+		
+		/*If the entry size is null, fail;*/
+		if (!sheader->sh_entsize)
+			return LOADER_ERR_TYPE_SECT_ENTSIZE_NULL;
+		
+		job->j_nb_symbols += sheader->sh_size / sheader->sh_entsize;
+		
+	}
+	
+	/*Reference each query in the index, with no definer;*/
+	for (nb_queries = 0; queries; queries = queries->s_next, nb_queries++) {
+		exports[nb_queries].e_name = queries->s_name;
+		exports[nb_queries].e_addr = queries;
+		winners[nb_queries] = (usize) -1;
+	}
+	job->j_nb_queries = nb_queries;
+	
+	/*Build the query index;*/
+	if (loader_export_table_init(&job->j_queries, exports, nb_queries,
+		buckets, nb_buckets, bloom, bloom_words))
+		return LOADER_ERROR_BAD_INDEX_SIZE;
+	
+	/*Complete;*/
+	return 0;
+	
+}
+
+/**
+ * loader_symbols_job_split : splits the job's symbols in @nb_chunks chunks of
+ * equal size;
+ * @param job : the job to split;
+ * @param chunks : the chunks to initialize;
+ * @param nb_chunks : the number of chunks, must not be null;
+ */
+void loader_symbols_job_split(
+	struct loader_symbols_job *job,
+	struct loader_symbols_chunk *chunks,
+	usize nb_chunks
+)
+{
+	
+	usize id;
+	usize first;
+	usize end;
+	
+	for (id = 0; id < nb_chunks; id++) {
+		
+		first = job->j_nb_symbols * id / nb_chunks;
+		end = job->j_nb_symbols * (id + 1) / nb_chunks;
+		
+		chunks[id].c_job = job;
+		chunks[id].c_first = first;
+		chunks[id].c_count = end - first;
+		chunks[id].c_error = 0;
+		
+	}
+	
+}
+
+/**
+ * loader_assign_symbols_chunk : assigns all symbols of the chunk; can be
+ * executed concurrently with other chunks of the same job;
+ * @param chunk : the chunk to process;
+ */
+void loader_assign_symbols_chunk(struct loader_symbols_chunk *chunk)
+{
+	
+	struct loader_symbols_job *job;
+	struct loading_env env;
+	struct elf_table shtable;
+	struct elf64_shdr *sheader;
+	usize base;
+	u8 error_id;
+	
+	/*Fetch the job;*/
+	job = chunk->c_job;
+	
+	/*Work on a private environment, with private stats;*/
+	env = *job->j_env;
+	if (env.r_stats) {
+		env.r_stats = &chunk->c_stats;
+		loader_stats_reset(env.r_stats);
+	}
+	
+	try(ctx, error_id) {
+			
+			/*Update the private error context;*/
+			env.r_error_ctx = &ctx;
+			
+			/*Fetch section header table descriptor;*/
+			shtable = env.r_shtable;
+			base = 0;
+			
+			/*Assign the chunk's slice of each symbol table;*/
+			TABLE_ITERATE(shtable, sheader) {
+				
+				if (sheader->sh_type == SHT_SYMTAB) {
+					base += assign_symbol_range(&env, sheader, job, base,
+						chunk->c_first, chunk->c_first + chunk->c_count);
+				}
+				
+			}
+			
+		}
+	
+	try_end
+	
+	/*Save the error;*/
+	chunk->c_error = error_id;
+	
+}
+
+/**
+ * loader_symbols_job_complete : merges chunks results once all chunks have
+ * been processed; if no chunk failed, defines each query with the value of
+ * its lowest-index definer;
+ * @param job : the job to complete;
+ * @param chunks : the job's chunks;
+ * @param nb_chunks : the number of chunks;
+ * @return 0 if all chunks succeeded, the error of the first failing chunk
+ * otherwise;
+ */
+u16 loader_symbols_job_complete(
+	struct loader_symbols_job *job,
+	struct loader_symbols_chunk *chunks,
+	usize nb_chunks
+)
+{
+	
+	struct loader_stats *stats;
+	struct loader_symbol *query;
+	usize id;
+	
+	/*Fetch the stats;*/
+	stats = job->j_env->r_stats;
+	
+	/*Merge chunks stats and report the first error;*/
+	for (id = 0; id < nb_chunks; id++) {
+		
+		if (chunks[id].c_error)
+			return chunks[id].c_error;
+		
+		if (stats) {
+			struct loader_stats *src = &chunks[id].c_stats;
+			stats->s_syms_internal += src->s_syms_internal;
+			stats->s_syms_external += src->s_syms_external;
+			stats->s_syms_unresolved += src->s_syms_unresolved;
+			stats->s_probes.p_lookups += src->s_probes.p_lookups;
+			stats->s_probes.p_layers += src->s_probes.p_layers;
+			stats->s_probes.p_bloom_rejects += src->s_probes.p_bloom_rejects;
+			stats->s_probes.p_chain_probes += src->s_probes.p_chain_probes;
+			if (src->s_probes.p_max_probes > stats->s_probes.p_max_probes)
+				stats->s_probes.p_max_probes = src->s_probes.p_max_probes;
+			stats->s_bytes_touched += src->s_bytes_touched;
+		}
+		
+	}
+	
+	/*Define each query that has a definer;*/
+	for (id = 0; id < job->j_nb_queries; id++) {
+		
+		if (job->j_winners[id] == (usize) -1)
+			continue;
+		
+		query = job->j_query_exports[id].e_addr;
+		query->s_defined = 1;
+		query->s_addr = (void *)
+			symbols_job_symbol(job->j_env, job->j_winners[id])->sy_value;
+		
+		if (stats)
+			stats->s_syms_queried++;
+		
+	}
+	
+	/*Complete;*/
+	return 0;
+	
+}
+
+/**
+ * loader_assign_symbols_par : splits the job in chunks, makes @run process
+ * them, and completes the job;
+ * @param job : the initialized job;
+ * @param chunks : the chunks storage;
+ * @param nb_chunks : the number of chunks, must not be null;
+ * @param run : a function that executes loader_assign_symbols_chunk on each
+ * provided chunk, on any number of workers, and returns once all chunks are
+ * processed;
+ * @param arg : the first argument to pass to @run;
+ * @return 0 if all symbols were assigned, the loading error otherwise;
+ */
+u16 loader_assign_symbols_par(
+	struct loader_symbols_job *job,
+	struct loader_symbols_chunk *chunks,
+	usize nb_chunks,
+	void (*run)(void *arg, struct loader_symbols_chunk *chunks, usize nb),
+	void *arg
+)
+{
+	
+	u16 error;
+	u64 start;
+	
+	/*Start the phase;*/
+	start = stats_phase_start(job->j_env);
+	
+	/*Split, run and complete;*/
+	loader_symbols_job_split(job, chunks, nb_chunks);
+	(*run)(arg, chunks, nb_chunks);
+	error = loader_symbols_job_complete(job, chunks, nb_chunks);
+	
+	/*End the phase;*/
+	stats_phase_end(job->j_env, LOADER_PHASE_SYMBOLS, start);
+	
+	/*Complete;*/
+	return error;
+	
+}
+
+/*--------------------------------------------------------------- relocations */
+
+/**
+ * loader_apply_relocation : apply the relocation @rel_type to @rel_addr,
+ * regarding symbol at @sym_addr and @addend; If the relocation fails to be
+ * applied, the function stops throws the related error;
+ * This function is processor-defined;
+ * @param rel_addr : the address to apply the relocation to;
+ * @param sym_addr : the address of the symbol the relocation concerns;
+ * @param addend : the relocation addend, null if none;
+ * @param rel_type : the relocation type;
+ * @return 0 if the relocation was applied correctly, LOADER_ERROR_REL_BAD_TYPE
+ * if bad relocation type, LOADER_ERROR_REL_VALUE_OVERFLOW if relocation value
+ * overflow.
+ */
+u8 loader_apply_relocation(
+	u64 rel_addr,
+	u64 sym_addr,
+	s64 addend,
+	u32 rel_type
+);
+
+/**
+ * apply_reloaction_table : for each relocation in the relocation table,
+ * verifies the relocation can be applied (symbol valid and defined), then
+ * calls the processor-defined function @loader_apply_relocation, to actually
+ * apply the relocation. If a relocation fails to be applied, the function
+ * stops throws the related error;
+ * @param env : the relocation environment;
+ * @param rel_table_hdr : the relocation table header;
+ */
+static void apply_reloaction_table(
+	struct loading_env *env,
+	struct elf64_shdr *rel_table_hdr
+)
+{
+	
+	u8 explicit_addend;
+	struct elf_table reltable;
+	u16 symtbl_id;
+	
+	u16 rel_sect_id;
+	struct elf64_shdr *rel_sect_hdr;
+	u64 rel_sect_start;
+	
+	struct elf_table symtbl;
+	struct elf64_rela *rel;
+	
+	
+	/*Determine whether an explicit addend is provided;*/
+	explicit_addend = (u8) (rel_table_hdr->sh_type == SHT_RELA);
+	
+	/*Fetch the relocation table;*/
+	__section_header_to_table(env, rel_table_hdr, &reltable);
+	
+	/*Report the relocation table walk;*/
+	stats_touch(env, &reltable);
+	
+	/*Fetch the symbol table header identifier;*/
+	symtbl_id = (u16) rel_table_hdr->sh_link;
+	
+	/*Fetch the symbol table;*/
+	__get_section_table(env, symtbl_id, SHT_SYMTAB, &symtbl);
+	
+	/*Fetch the index of the section to relocate;*/
+	rel_sect_id = (u16) rel_table_hdr->sh_info;
+	
+	/*Fetch the header of the section to relocate;*/
+	rel_sect_hdr = __get_section_header(env, rel_sect_id, SHT_PROGBITS);
+	
+	/*Fetch the start and size of the section whose content will be changed;*/
+	rel_sect_start = rel_sect_hdr->sh_addr;
+	
+	/*Iterate over the relocation table;*/
+	TABLE_ITERATE(reltable, rel) {
+		u64 rel_addr;
 		u64 rel_info;
 		u32 sym_index;
 		u32 rel_type;
@@ -609,6 +1670,48 @@ static void apply_reloaction_table(
 			loading_error(env, rel_error);
 		}
 		
+		/*Report the relocation type;*/
+		if (env->r_stats) {
+			env->r_stats->s_relocations[
+				(rel_type < LOADER_STATS_NB_REL_TYPES) ?
+				rel_type : LOADER_STATS_NB_REL_TYPES - 1]++;
+		}
+		
+	}
+	
+}
+
+/**
+ * apply_relocation_tables : calls the relocation table application function
+ * for each relocation table in the environment; loading errors are thrown to
+ * the environment's error context;
+ * @param env : the relocation environment;
+ */
+static void apply_relocation_tables(struct loading_env *env)
+{
+	
+	struct elf_table shtable;
+	struct elf64_shdr *shdr;
+	
+	/*Fetch the symbol table descriptor;*/
+	shtable = env->r_shtable;
+	
+	/*Iterate over the section table :*/
+	TABLE_ITERATE(shtable, shdr) {
+		
+		u32 sh_type;
+		
+		/*Fetch the section type;*/
+		sh_type = shdr->sh_type;
+		
+		/*If the section contains a relocation table :*/
+		if ((sh_type == SHT_REL) || (sh_type == SHT_RELA)) {
+			
+			/*Attempt to apply relocations;*/
+			apply_reloaction_table(env, shdr);
+			
+		}
+		
 	}
 	
 }
@@ -626,12 +1729,11 @@ static void apply_reloaction_table(
 u8 rmld_apply_relocations(struct loading_env *env)
 {
 	
-	struct elf_table shtable;
-	struct elf64_shdr *shdr;
 	u8 error_id;
+	u64 start;
 	
-	/*Fetch the symbol table descriptor;*/
-	shtable = env->r_shtable;
+	/*Start the phase;*/
+	start = stats_phase_start(env);
 	
 	try(ctx, error_id) {
 			
@@ -639,32 +1741,325 @@ u8 rmld_apply_relocations(struct loading_env *env)
 			/*Reset at exception exit, to avoid scope escapism;*/
 			env->r_error_ctx = &ctx;
 			
-			/*Iterate over the section table :*/
-			TABLE_ITERATE(shtable, shdr) {
-				
-				u32 sh_type;
-				
-				/*Fetch the section type;*/
-				sh_type = shdr->sh_type;
+			/*Apply relocations of all relocation tables;*/
+			apply_relocation_tables(env);
+			
+		}
+	
+	try_end
+	
+	/*Reset the internal error context to avoid scope escapism;*/
+	env->r_error_ctx = 0;
+	
+	/*End the phase;*/
+	stats_phase_end(env, LOADER_PHASE_RELOCATIONS, start);
+	
+	/*Return the error id;*/
+	return error_id;
+	
+}
+
+/*-------------------------------------------------------------- batch loading*/
+
+/**
+ * loader_batch_arena_size : determines the size of the arena required to
+ * hold all modules of a batch;
+ * @param modules : the modules, with their size initialized;
+ * @param nb_modules : the number of modules;
+ * @return the required arena size in bytes;
+ */
+usize loader_batch_arena_size(
+	struct loader_module *modules,
+	usize nb_modules
+)
+{
+	
+	usize size;
+	usize id;
+	
+	/*Sum aligned module sizes;*/
+	size = 0;
+	for (id = 0; id < nb_modules; id++) {
+		size += (modules[id].m_size + LOADER_BATCH_ALIGN - 1) &
+			~(usize) (LOADER_BATCH_ALIGN - 1);
+	}
+	
+	/*Complete;*/
+	return size;
+	
+}
+
+/**
+ * loader_batch_init : initializes the batch and lays all module images out
+ * contiguously in the arena, in the order of the module array;
+ * @param batch : the batch to initialize;
+ * @param modules : the modules, with their size and queries initialized;
+ * @param nb_modules : the number of modules;
+ * @param arena : the arena, aligned on LOADER_BATCH_ALIGN;
+ * @param arena_size : the size of the arena in bytes;
+ * @return 0 if all modules were laid out, 1 if the arena is too small;
+ */
+u8 loader_batch_init(
+	struct loader_batch *batch,
+	struct loader_module *modules,
+	usize nb_modules,
+	void *arena,
+	usize arena_size
+)
+{
+	
+	usize offset;
+	usize id;
+	
+	/*If the arena is too small, fail;*/
+	if (loader_batch_arena_size(modules, nb_modules) > arena_size)
+		return 1;
+	
+	/*Initialize the batch;*/
+	batch->b_modules = modules;
+	batch->b_nb_modules = nb_modules;
+	batch->b_arena = arena;
+	batch->b_arena_size = arena_size;
+	
+	/*Assign each module its slice of the arena;*/
+	offset = 0;
+	for (id = 0; id < nb_modules; id++) {
+		
+		modules[id].m_image = ptr_sum_byte_offset(arena, offset);
+		modules[id].m_error = 0;
+		modules[id].m_phase = 0;
+		
+		offset += (modules[id].m_size + LOADER_BATCH_ALIGN - 1) &
+			~(usize) (LOADER_BATCH_ALIGN - 1);
+		
+	}
+	
+	/*Complete;*/
+	return 0;
+	
+}
+
+/**
+ * batch_fail : marks a module failed;
+ * @param module : the module that failed;
+ * @param phase : the phase the module failed in;
+ * @param error : the loading error;
+ */
+static void batch_fail(struct loader_module *module, u8 phase, u16 error)
+{
+	module->m_phase = phase;
+	module->m_error = error;
+}
+
+/**
+ * batch_phase : executes a symbols or relocations phase on each valid module
+ * of the batch, under a single error context; a failing module is marked
+ * and the phase resumes with the next module;
+ * @param batch : the batch to process;
+ * @param phase : LOADER_PHASE_SYMBOLS or LOADER_PHASE_RELOCATIONS;
+ * @param defs : a list of defined symbols, used if @ns is null;
+ * @param ns : a namespace to search for definitions, 0 if none;
+ */
+static void batch_phase(
+	struct loader_batch *batch,
+	u8 phase,
+	struct loader_symbol *defs,
+	struct loader_namespace *ns
+)
+{
+	
+	/*Volatile, as it is read after a context restoration;*/
+	volatile usize id;
+	struct loader_module *module;
+	u8 error_id;
+	
+	id = 0;
+	while (id < batch->b_nb_modules) {
+		
+		try(ctx, error_id) {
 				
-				/*If the section contains a relocation table :*/
-				if ((sh_type == SHT_REL) || (sh_type == SHT_RELA)) {
+				/*For each remaining module :*/
+				for (; id < batch->b_nb_modules; id++) {
+					
+					module = batch->b_modules + id;
+					
+					/*Skip modules that failed in a previous phase;*/
+					if (module->m_error)
+						continue;
+					
+					/*Update the module's error context;*/
+					module->m_env.r_error_ctx = &ctx;
+					
+					/*Execute the phase;*/
+					if (phase == LOADER_PHASE_SYMBOLS) {
+						assign_symbol_tables(
+							&module->m_env, defs, ns, module->m_queries
+						);
+					} else {
+						apply_relocation_tables(&module->m_env);
+					}
 					
-					/*Attempt to apply relocations;*/
-					apply_reloaction_table(env, shdr);
+					/*Reset the error context to avoid scope escapism;*/
+					module->m_env.r_error_ctx = 0;
 					
 				}
 				
 			}
-			
+		
+		try_end
+		
+		/*If a module failed, mark it and resume with the next one;*/
+		if (error_id) {
+			module = batch->b_modules + id;
+			module->m_env.r_error_ctx = 0;
+			batch_fail(module, phase, error_id);
+			id++;
 		}
+		
+	}
 	
-	try_end
+}
+
+/**
+ * loader_batch_load : loads all modules of the batch, whose images must have
+ * been read in the arena; each phase is executed on all modules before the
+ * next one starts; a module that fails is skipped in next phases;
+ * @param batch : the batch to load;
+ * @param defs : a list of defined symbols, used if @ns is null;
+ * @param ns : a namespace to search for definitions, 0 if none;
+ * @param stats : the stats to update, 0 to disable instrumentation;
+ * @return the number of modules that failed to load;
+ */
+usize loader_batch_load(
+	struct loader_batch *batch,
+	struct loader_symbol *defs,
+	struct loader_namespace *ns,
+	struct loader_stats *stats
+)
+{
 	
-	/*Reset the internal error context to avoid scope escapism;*/
-	env->r_error_ctx = 0;
+	struct loader_module *module;
+	usize nb_failed;
+	usize id;
+	u8 error;
+	u64 start;
+	
+	/*Initialize all environments;*/
+	for (id = 0; id < batch->b_nb_modules; id++) {
+		module = batch->b_modules + id;
+		loader_init_stats(&module->m_env, module->m_image, stats);
+	}
+	
+	/*Assign sections of all modules;*/
+	for (id = 0; id < batch->b_nb_modules; id++) {
+		module = batch->b_modules + id;
+		error = loader_assign_sections(&module->m_env);
+		if (error)
+			batch_fail(module, LOADER_PHASE_LAYOUT, error);
+	}
+	
+	/*Assign symbols of all modules;*/
+	start = (stats) ? loader_cycles() : 0;
+	batch_phase(batch, LOADER_PHASE_SYMBOLS, defs, ns);
+	if (stats)
+		stats->s_cycles[LOADER_PHASE_SYMBOLS] += loader_cycles() - start;
+	
+	/*Apply relocations of all modules;*/
+	start = (stats) ? loader_cycles() : 0;
+	batch_phase(batch, LOADER_PHASE_RELOCATIONS, 0, 0);
+	if (stats)
+		stats->s_cycles[LOADER_PHASE_RELOCATIONS] += loader_cycles() - start;
+	
+	/*Count failed modules;*/
+	nb_failed = 0;
+	for (id = 0; id < batch->b_nb_modules; id++) {
+		if (batch->b_modules[id].m_error)
+			nb_failed++;
+	}
 	
 	/*Complete;*/
-	return 0;
+	return nb_failed;
+	
+}
+
+/*---------------------------------------------------------------------- stats*/
+
+/**
+ * loader_stats_reset : resets all counters of the provided stats;
+ * @param stats : the stats to reset;
+ */
+void loader_stats_reset(struct loader_stats *stats)
+{
+	
+	u8 id;
+	
+	for (id = 0; id < LOADER_NB_PHASES; id++) {
+		stats->s_cycles[id] = 0;
+	}
+	
+	stats->s_syms_internal = 0;
+	stats->s_syms_external = 0;
+	stats->s_syms_unresolved = 0;
+	stats->s_syms_queried = 0;
+	
+	for (id = 0; id < LOADER_STATS_NB_REL_TYPES; id++) {
+		stats->s_relocations[id] = 0;
+	}
+	
+	stats->s_probes.p_lookups = 0;
+	stats->s_probes.p_layers = 0;
+	stats->s_probes.p_bloom_rejects = 0;
+	stats->s_probes.p_chain_probes = 0;
+	stats->s_probes.p_max_probes = 0;
+	
+	stats->s_bytes_touched = 0;
+	
+}
+
+/**
+ * loader_stats_dump : reports each counter of the provided stats, by calling
+ * @emit with the counter's name and value; relocation types with no
+ * occurrence are not reported;
+ * @param stats : the stats to dump;
+ * @param emit : the function to call for each counter;
+ * @param arg : the first argument to pass to @emit;
+ */
+void loader_stats_dump(
+	struct loader_stats *stats,
+	void (*emit)(void *arg, const char *name, usize index, u64 value),
+	void *arg
+)
+{
+	
+	u8 id;
+	
+	/*Phases cycles;*/
+	(*emit)(arg, "cycles_init", 0, stats->s_cycles[LOADER_PHASE_INIT]);
+	(*emit)(arg, "cycles_layout", 0, stats->s_cycles[LOADER_PHASE_LAYOUT]);
+	(*emit)(arg, "cycles_symbols", 0, stats->s_cycles[LOADER_PHASE_SYMBOLS]);
+	(*emit)(arg, "cycles_relocations", 0,
+		stats->s_cycles[LOADER_PHASE_RELOCATIONS]);
+	
+	/*Symbols;*/
+	(*emit)(arg, "syms_internal", 0, stats->s_syms_internal);
+	(*emit)(arg, "syms_external", 0, stats->s_syms_external);
+	(*emit)(arg, "syms_unresolved", 0, stats->s_syms_unresolved);
+	(*emit)(arg, "syms_queried", 0, stats->s_syms_queried);
+	
+	/*Relocations, indexed by type;*/
+	for (id = 0; id < LOADER_STATS_NB_REL_TYPES; id++) {
+		if (stats->s_relocations[id])
+			(*emit)(arg, "relocations", id, stats->s_relocations[id]);
+	}
+	
+	/*Lookups;*/
+	(*emit)(arg, "lookups", 0, stats->s_probes.p_lookups);
+	(*emit)(arg, "lookup_layers", 0, stats->s_probes.p_layers);
+	(*emit)(arg, "lookup_bloom_rejects", 0, stats->s_probes.p_bloom_rejects);
+	(*emit)(arg, "lookup_chain_probes", 0, stats->s_probes.p_chain_probes);
+	(*emit)(arg, "lookup_max_probes", 0, stats->s_probes.p_max_probes);
+	
+	/*Memory;*/
+	(*emit)(arg, "bytes_touched", 0, stats->s_bytes_touched);
 	
 }
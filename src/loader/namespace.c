@@ -0,0 +1,291 @@
+/*namespace.c - kerneltk - GPLV3, copyleft 2019 Raphael Outhier;*/
+
+#include <loader/namespace.h>
+
+#include <string.h>
+
+/*The number of bits in a bloom filter word;*/
+#define BLOOM_WORD_BITS (8 * sizeof(usize))
+
+/*------------------------------------------------------------------ internals*/
+
+/**
+ * bloom_word : determines the bloom word a hash relates to;
+ * @param table : the table the hash is checked against;
+ * @param hash : the hash of the symbol;
+ * @return the ref of the word the hash relates to;
+ */
+static __inline__ usize *bloom_word(
+	struct loader_export_table *table,
+	u32 hash
+)
+{
+	return table->t_bloom + ((hash / BLOOM_WORD_BITS) & table->t_bloom_mask);
+}
+
+/**
+ * bloom_mask : determines the two bits a hash sets in its bloom word;
+ * @param hash : the hash of the symbol;
+ * @return the mask of bits related to @hash;
+ */
+static __inline__ usize bloom_mask(u32 hash)
+{
+	return ((usize) 1 << (hash % BLOOM_WORD_BITS)) |
+		((usize) 1 << ((hash >> LOADER_BLOOM_SHIFT) % BLOOM_WORD_BITS));
+}
+
+/*---------------------------------------------------------------- hash tables*/
+
+/**
+ * loader_symbol_hash : computes the GNU_HASH hash of the provided name;
+ * @param name : the name to hash;
+ * @return the hash of @name;
+ */
+u32 loader_symbol_hash(const char *name)
+{
+
+	u32 hash;
+	u8 c;
+
+	/*Initialize the hash;*/
+	hash = 5381;
+
+	/*For each character, update the hash;*/
+	while ((c = (u8) *(name++))) {
+		hash = (hash << 5) + hash + c;
+	}
+
+	/*Complete;*/
+	return hash;
+
+}
+
+/**
+ * loader_export_table_init : hashes all exports, builds their bucket chains
+ * and fills the bloom filter;
+ * @param table : the table to initialize;
+ * @param exports : the array of exports to reference; names and addresses
+ * must be initialized;
+ * @param nb_exports : the number of exports in @exports;
+ * @param buckets : the bucket array, of @nb_buckets entries;
+ * @param nb_buckets : the number of buckets, must not be null;
+ * @param bloom : the bloom filter array, of @bloom_words entries;
+ * @param bloom_words : the number of bloom words, must be a power of 2;
+ * @return 0 if the table was initialized, 1 if a size was invalid;
+ */
+u8 loader_export_table_init(
+	struct loader_export_table *table,
+	struct loader_export *exports,
+	usize nb_exports,
+	struct loader_export **buckets,
+	usize nb_buckets,
+	usize *bloom,
+	usize bloom_words
+)
+{
+
+	usize id;
+
+	/*If no bucket is provided or bloom size is not a power of 2, fail;*/
+	if ((!nb_buckets) || (!bloom_words) || (bloom_words & (bloom_words - 1)))
+		return 1;
+
+	/*Initialize the table;*/
+	table->t_next = 0;
+	table->t_bloom = bloom;
+	table->t_bloom_mask = bloom_words - 1;
+	table->t_buckets = buckets;
+	table->t_nb_buckets = nb_buckets;
+
+	/*Reset all buckets and bloom words;*/
+	for (id = 0; id < nb_buckets; id++) {
+		buckets[id] = 0;
+	}
+	for (id = 0; id < bloom_words; id++) {
+		bloom[id] = 0;
+	}
+
+	/*Insert exports from the last to the first, so that chains keep the
+	 * declaration order;*/
+	for (id = nb_exports; id--;) {
+
+		struct loader_export *export;
+		struct loader_export **bucket;
+		u32 hash;
+
+		/*Fetch the export and hash its name;*/
+		export = exports + id;
+		export->e_hash = hash = loader_symbol_hash(export->e_name);
+
+		/*Insert the export at the head of its bucket's chain;*/
+		bucket = buckets + (hash % nb_buckets);
+		export->e_next = *bucket;
+		*bucket = export;
+
+		/*Set the export's bits in the bloom filter;*/
+		*bloom_word(table, hash) |= bloom_mask(hash);
+
+	}
+
+	/*Complete;*/
+	return 0;
+
+}
+
+/**
+ * loader_export_table_find : searches the table for an export of the
+ * provided name;
+ * @param table : the table to search;
+ * @param name : the name of the symbol;
+ * @param hash : the hash of @name;
+ * @param probes : probe counters to update, 0 if none;
+ * @return the matching export if any, 0 if none;
+ */
+struct loader_export *loader_export_table_find(
+	struct loader_export_table *table,
+	const char *name,
+	u32 hash,
+	struct loader_probe_stats *probes
+)
+{
+
+	struct loader_export *export;
+	usize mask;
+	usize nb_probes;
+
+	/*If both bits are not set in the bloom filter, the name is not defined;*/
+	mask = bloom_mask(hash);
+	if ((*bloom_word(table, hash) & mask) != mask) {
+
+		/*Report the rejection if required;*/
+		if (probes)
+			probes->p_bloom_rejects++;
+
+		return 0;
+
+	}
+
+	/*Walk the bucket's chain;*/
+	export = table->t_buckets[hash % table->t_nb_buckets];
+	nb_probes = 0;
+	while (export) {
+
+		nb_probes++;
+
+		/*Only compare names if hashes match;*/
+		if ((export->e_hash == hash) && (str_cmp(name, export->e_name) == 0))
+			break;
+
+		export = export->e_next;
+
+	}
+
+	/*Report the chain walk if required;*/
+	if (probes) {
+		probes->p_chain_probes += nb_probes;
+		if (nb_probes > probes->p_max_probes)
+			probes->p_max_probes = nb_probes;
+	}
+
+	/*Return the matching export if any;*/
+	return export;
+
+}
+
+/*----------------------------------------------------------------- namespaces*/
+
+/**
+ * loader_namespace_init : initializes an empty namespace;
+ * @param ns : the namespace to initialize;
+ */
+void loader_namespace_init(struct loader_namespace *ns)
+{
+	ns->n_top = 0;
+}
+
+/**
+ * loader_namespace_push : pushes a table on the top of the namespace; its
+ * exports will shadow exports of the same name in all lower layers;
+ * @param ns : the namespace to update;
+ * @param table : the initialized table to push;
+ */
+void loader_namespace_push(
+	struct loader_namespace *ns,
+	struct loader_export_table *table
+)
+{
+
+	/*Link the table above the current top layer;*/
+	table->t_next = ns->n_top;
+	ns->n_top = table;
+
+}
+
+/**
+ * loader_namespace_pop : removes the top layer of the namespace;
+ * @param ns : the namespace to update;
+ * @return the removed layer, 0 if the namespace was empty;
+ */
+struct loader_export_table *loader_namespace_pop(struct loader_namespace *ns)
+{
+
+	struct loader_export_table *table;
+
+	/*Fetch the top layer;*/
+	table = ns->n_top;
+
+	/*If the namespace is not empty, unlink its top layer;*/
+	if (table) {
+		ns->n_top = table->t_next;
+		table->t_next = 0;
+	}
+
+	/*Complete;*/
+	return table;
+
+}
+
+/**
+ * loader_namespace_find : searches the namespace, from the top layer to the
+ * bottom one, for an export of the provided name;
+ * @param ns : the namespace to search;
+ * @param name : the name of the symbol;
+ * @param probes : probe counters to update, 0 if none;
+ * @return the first matching export if any, 0 if none;
+ */
+struct loader_export *loader_namespace_find(
+	struct loader_namespace *ns,
+	const char *name,
+	struct loader_probe_stats *probes
+)
+{
+
+	struct loader_export_table *table;
+	struct loader_export *export;
+	u32 hash;
+
+	/*Hash the name once for all layers;*/
+	hash = loader_symbol_hash(name);
+
+	/*Report the lookup if required;*/
+	if (probes)
+		probes->p_lookups++;
+
+	/*For each layer, from the top to the bottom :*/
+	for (table = ns->n_top; table; table = table->t_next) {
+
+		/*Report the layer visit if required;*/
+		if (probes)
+			probes->p_layers++;
+
+		/*If the layer defines the symbol, it shadows lower layers;*/
+		export = loader_export_table_find(table, name, hash, probes);
+		if (export)
+			return export;
+
+	}
+
+	/*If no layer defines the symbol, return 0;*/
+	return 0;
+
+}
@@ -0,0 +1,61 @@
+/*barrier.c - kerneltk - GPLV3, copyleft 2019 Raphael Outhier;*/
+
+#include <sched/barrier.h>
+
+#include <check.h>
+
+/**
+ * sched_barrier_ctor : constructs the barrier and registers it to the
+ * provided process;
+ * @param barrier : the barrier to construct;
+ * @param prc : the process to register the barrier to;
+ * @param nb_parties : the number of tasks that complete a phase, not null;
+ */
+void sched_barrier_ctor(
+		struct sched_barrier *barrier,
+		struct sprocess *prc,
+		usize nb_parties
+) {
+
+	/*Args check;*/
+	ns_check(barrier);
+	ns_check(prc);
+	ns_check(nb_parties);
+
+	/*Initialize and register the barrier;*/
+	barrier->b_nb_parties = nb_parties;
+	barrier->b_nb_arrived = 0;
+	barrier->b_phase = 0;
+	process_register_prim(prc, &barrier->b_prim);
+
+}
+
+/**
+ * sched_barrier_wait : reports the arrival of the thread's task; if it
+ * completes the phase, all stopped tasks are resumed and the task continues;
+ * if not, the task is stopped and a new one is assigned to the thread;
+ * @param barrier : the barrier to arrive at;
+ * @param thread : the thread executing the arriving task;
+ * @return 1 if the task completed the phase, 0 if it was stopped;
+ */
+u8 sched_barrier_wait(struct sched_barrier *barrier, struct sthread *thread) {
+
+	/*Args check;*/
+	ns_check(barrier);
+	ns_check(thread);
+
+	/*If the task doesn't complete the phase, stop it;*/
+	if (++barrier->b_nb_arrived < barrier->b_nb_parties) {
+		primitive_stop_thread(&barrier->b_prim, thread);
+		return 0;
+	}
+
+	/*Start a new phase, and resume all arrived tasks at once;*/
+	barrier->b_nb_arrived = 0;
+	barrier->b_phase++;
+	primitive_resume_all(&barrier->b_prim);
+
+	/*Complete;*/
+	return 1;
+
+}
@@ -0,0 +1,137 @@
+/*cond.c - kerneltk - GPLV3, copyleft 2019 Raphael Outhier;*/
+
+#include <sched/cond.h>
+
+#include <check.h>
+
+
+/**
+ * cond_wake : wakes the first waiting task; if the mutex is locked, or if a
+ * task was already resumed to take it, the task is transferred to the mutex's
+ * stopped list; if not, it is resumed;
+ * @param cond : the condition variable to wake a task of;
+ * @param resumable : 0 if a task was already resumed to take the mutex;
+ * @return 1 if a task was woken, 0 if none was waiting;
+ */
+static u8 cond_wake(struct sched_cond *cond, u8 resumable) {
+
+	struct sched_mutex *mutex;
+	struct stask *task;
+
+	/*Fetch the first waiting task; if none, complete;*/
+	task = primitive_first_stopped(&cond->c_prim);
+	if (!task)
+		return 0;
+
+	/*Fetch the mutex;*/
+	mutex = cond->c_mutex;
+
+	/*Make the mutex contended, so that its next unlock resumes the task; if
+	 * the mutex is taken, the task waits for it, without being resumed;*/
+	if ((sched_mutex_contend(mutex)) || (!resumable)) {
+
+		primitive_transfer_task(&mutex->m_prim, task);
+
+	} else {
+
+		/*If not, resume the task, so that it takes the mutex;*/
+		primitive_resume_task(task);
+
+	}
+
+	/*Complete;*/
+	return 1;
+
+}
+
+/**
+ * sched_cond_ctor : constructs the condition variable, associates it with the
+ * mutex and registers it to the provided process;
+ * @param cond : the condition variable to construct;
+ * @param prc : the process to register the condition variable to;
+ * @param mutex : the mutex to associate, registered to the same process;
+ */
+void sched_cond_ctor(
+		struct sched_cond *cond,
+		struct sprocess *prc,
+		struct sched_mutex *mutex
+) {
+
+	/*Args check;*/
+	ns_check(cond);
+	ns_check(prc);
+	ns_check(mutex);
+	ns_check(mutex->m_prim.p_process == prc);
+
+	/*Register the primitive and associate the mutex;*/
+	process_register_prim(prc, &cond->c_prim);
+	cond->c_mutex = mutex;
+
+}
+
+/**
+ * sched_cond_wait : unlocks the associated mutex, stops the thread's task and
+ * assigns a new one to the thread; once resumed, the task must lock the mutex;
+ * @param cond : the condition variable to wait for;
+ * @param thread : the thread executing the task that must wait;
+ * @return 0 if the task waits, the error of sched_mutex_unlock if the mutex
+ * could not be unlocked;
+ */
+err_t sched_cond_wait(struct sched_cond *cond, struct sthread *thread) {
+
+	err_t error;
+
+	/*Args check;*/
+	ns_check(cond);
+	ns_check(thread);
+
+	/*Unlock the mutex; if an error occurred, fail;*/
+	error = sched_mutex_unlock(cond->c_mutex, thread);
+	if (error)
+		return error;
+
+	/*Stop the thread's task;*/
+	primitive_stop_thread(&cond->c_prim, thread);
+
+	/*Complete;*/
+	return 0;
+
+}
+
+/**
+ * sched_cond_signal : wakes the first waiting task if any;
+ * @param cond : the condition variable to signal;
+ * @return 1 if a task was woken, 0 if none was waiting;
+ */
+u8 sched_cond_signal(struct sched_cond *cond) {
+
+	/*Args check;*/
+	ns_check(cond);
+
+	return cond_wake(cond, 1);
+
+}
+
+/**
+ * sched_cond_broadcast : wakes all waiting tasks;
+ * @param cond : the condition variable to signal;
+ * @return the number of woken tasks;
+ */
+usize sched_cond_broadcast(struct sched_cond *cond) {
+
+	usize nb_woken;
+
+	/*Args check;*/
+	ns_check(cond);
+
+	/*Wake tasks while some wait; at most the first one is resumed, the
+	 * others wait for the mutex;*/
+	nb_woken = 0;
+	while (cond_wake(cond, (u8) (nb_woken == 0))) {
+		nb_woken++;
+	}
+
+	/*Complete;*/
+	return nb_woken;
+
+}
@@ -0,0 +1,82 @@
+/*latch.c - kerneltk - GPLV3, copyleft 2019 Raphael Outhier;*/
+
+#include <sched/latch.h>
+
+#include <check.h>
+
+/**
+ * sched_latch_ctor : constructs the latch and registers it to the provided
+ * process;
+ * @param latch : the latch to construct;
+ * @param prc : the process to register the latch to;
+ * @param count : the number of count downs before the latch opens;
+ */
+void sched_latch_ctor(
+		struct sched_latch *latch,
+		struct sprocess *prc,
+		usize count
+) {
+
+	/*Args check;*/
+	ns_check(latch);
+	ns_check(prc);
+
+	/*Initialize and register the latch;*/
+	latch->l_count = count;
+	process_register_prim(prc, &latch->l_prim);
+
+}
+
+/**
+ * sched_latch_count_down : decreases the count of the latch; if it reaches
+ * zero, all waiting tasks are resumed at once;
+ * @param latch : the latch to count down;
+ * @param nb : the number of count downs;
+ * @return 1 if the latch is open, 0 if not;
+ */
+u8 sched_latch_count_down(struct sched_latch *latch, usize nb) {
+
+	/*Args check;*/
+	ns_check(latch);
+
+	/*If the latch is already open, nothing to do;*/
+	if (!latch->l_count)
+		return 1;
+
+	/*Decrease the count, saturating at zero;*/
+	latch->l_count = (nb < latch->l_count) ? latch->l_count - nb : 0;
+
+	/*If the latch is not open, complete;*/
+	if (latch->l_count)
+		return 0;
+
+	/*Resume all waiting tasks at once;*/
+	primitive_resume_all(&latch->l_prim);
+
+	/*Complete;*/
+	return 1;
+
+}
+
+/**
+ * sched_latch_wait : if the latch is not open, stops the thread's task and
+ * assigns a new one to the thread;
+ * @param latch : the latch to wait for;
+ * @param thread : the thread executing the task that must wait;
+ * @return 1 if the latch is open, 0 if the task was stopped;
+ */
+u8 sched_latch_wait(struct sched_latch *latch, struct sthread *thread) {
+
+	/*Args check;*/
+	ns_check(latch);
+	ns_check(thread);
+
+	/*If the latch is open, complete;*/
+	if (!latch->l_count)
+		return 1;
+
+	/*Stop the thread's task;*/
+	primitive_stop_thread(&latch->l_prim, thread);
+	return 0;
+
+}
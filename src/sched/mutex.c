@@ -20,6 +20,122 @@ void sched_mutex_ctor(struct sched_mutex *mutex, struct sprocess *prc) {
 	/*Register the primitive to the scheduler;*/
 	process_register_prim(prc, &mutex->m_prim);
 
+	/*Initialize the adaptive spin state;*/
+	mutex->m_spin_limit = SCHED_MUTEX_SPIN_INIT;
+	mutex->m_nb_spin_acquired = 0;
+	mutex->m_nb_parked = 0;
+
+	/*The mutex is unlocked and not contended;*/
+	mutex->m_owner = 0;
+
+}
+
+/**
+ * mutex_owner : determines the task that owns the mutex; the result is
+ * purely indicative if the process is unlocked;
+ * @param mutex : the mutex to check;
+ * @return the owner of @mutex, 0 if it is unlocked;
+ */
+static __inline__ struct stask *mutex_owner(struct sched_mutex *mutex) {
+
+	return (struct stask *) (mutex->m_owner & ~SCHED_MUTEX_CONTENDED);
+
+}
+
+/**
+ * mutex_acquire : if the mutex is unlocked, makes the task its owner; if the
+ * mutex is contended, its primitive overrides the task, or raises it to its
+ * ceiling if the ceiling mode is enabled; the process must be locked;
+ * @param mutex : the mutex to lock;
+ * @param task : the task that must lock the mutex;
+ * @return 1 if the task owns the mutex, 0 if the mutex was locked;
+ */
+static u8 mutex_acquire(struct sched_mutex *mutex, struct stask *task) {
+
+	usize word;
+
+	/*Set the owner, unless the mutex is locked; fast unlocks may compete;*/
+	do {
+		word = mutex->m_owner;
+		if (word & ~SCHED_MUTEX_CONTENDED)
+			return 0;
+	} while (!__sync_bool_compare_and_swap(&mutex->m_owner, word,
+		(usize) task | word));
+
+	/*Raise the task to the ceiling, or make the primitive override it if
+	 * tasks are stopped;*/
+	if (mutex->m_prim.p_status & SCHED_PRIM_STATUS_CEILING) {
+		primitive_ceiling_take(&mutex->m_prim, task);
+	} else if (word & SCHED_MUTEX_CONTENDED) {
+		primitive_override_task(&mutex->m_prim, task);
+	}
+
+	/*Complete;*/
+	return 1;
+
+}
+
+/**
+ * sched_mutex_contend : sets the contention bit of the mutex, so that its next
+ * unlock takes the process lock and resumes stopped tasks; if the mutex is
+ * locked and was not contended, its primitive overrides the owner;
+ * must be called before tasks are stopped by, or transferred to, the mutex's
+ * primitive;
+ * @param mutex : the mutex to update;
+ * @return 1 if the mutex is locked, 0 if not;
+ */
+u8 sched_mutex_contend(struct sched_mutex *mutex) {
+
+	usize word;
+
+	/*Args check;*/
+	ns_check(mutex);
+
+	/*Set the contention bit; fast unlocks may compete;*/
+	do {
+		word = mutex->m_owner;
+		if (word & SCHED_MUTEX_CONTENDED)
+			return (u8) (mutex_owner(mutex) != 0);
+	} while (!__sync_bool_compare_and_swap(&mutex->m_owner, word,
+		word | SCHED_MUTEX_CONTENDED));
+
+	/*If the mutex is unlocked, its next owner will be overridden;*/
+	if (!word)
+		return 0;
+
+	/*The owner locked the mutex without override; set it up now;*/
+	if (!(mutex->m_prim.p_status & SCHED_PRIM_STATUS_CEILING))
+		primitive_override_task(&mutex->m_prim, (struct stask *) word);
+
+	/*Complete;*/
+	return 1;
+
+}
+
+/**
+ * mutex_lock : locks the mutex if it is unlocked; if not, makes it contended,
+ * stops the thread's task and assigns a new one to the thread; the process
+ * must be locked;
+ * @param mutex : the mutex to lock;
+ * @param thread : the thread executing the task that must lock the mutex;
+ * @return 1 if the mutex was locked, 0 if the task was stopped;
+ */
+static u8 mutex_lock(struct sched_mutex *mutex, struct sthread *thread) {
+
+	/*While the mutex can't be acquired :*/
+	while (!mutex_acquire(mutex, thread->t_task)) {
+
+		/*If the mutex is still locked once contended, stop the task;*/
+		if (sched_mutex_contend(mutex)) {
+			primitive_stop_thread(&mutex->m_prim, thread);
+			return 0;
+		}
+
+	}
+
+	/*Complete;*/
+	return 1;
+
 }
 
 /**
@@ -35,22 +151,9 @@ void sched_mutex_lock(struct sched_mutex *mutex, struct sthread *thread) {
 	ns_check(mutex);
 	ns_check(thread);
 
-	/*If the mutex is locked :*/
-	if (mutex->m_prim.p_nb_owning_tasks) {
-
-		/*Stop the thread's task;*/
-		primitive_stop_thread(&mutex->m_prim, thread);
+	/*Lock the mutex, or stop the task;*/
+	mutex_lock(mutex, thread);
 
-	} else {
-		/*If the mutex is unlocked :*/
-
-		/*Give the thread's task the ownership of the mutex;*/
-		primitive_take_ownership(&mutex->m_prim, thread->t_task);
-		
-		/*Make the primitive override the task;*/
-		primitive_override_task(&mutex->m_prim, thread->t_task);
-		
-	}
 }
 
 /**
@@ -66,24 +169,163 @@ u8 sched_mutex_lock_nb(struct sched_mutex *mutex, struct sthread *thread) {
 	ns_check(mutex);
 	ns_check(thread);
 
-	/*If the mutex is locked :*/
-	if (mutex->m_prim.p_nb_owning_tasks) {
+	/*Attempt to lock the mutex;*/
+	return mutex_acquire(mutex, thread->t_task);
 
-		/*Fail;*/
+}
+
+/**
+ * mutex_owner_running : determines whether the owner of the mutex is being
+ * executed by another thread than the provided one; the result is purely
+ * indicative if the process is unlocked;
+ * @param mutex : the mutex to check;
+ * @param thread : the thread of the caller;
+ * @return 1 if the owner is executed by another thread, 0 if not;
+ */
+static u8 mutex_owner_running(struct sched_mutex *mutex, struct sthread *thread) {
+
+	struct stask *owner;
+	struct sthread *owner_thread;
+
+	/*Fetch the owner and its thread;*/
+	owner = mutex_owner(mutex);
+	if (!owner)
 		return 0;
+	owner_thread = *(struct sthread *volatile *) &owner->t_thread;
+
+	/*The owner runs if its thread is another one, and still executes it;*/
+	return (u8) ((owner_thread) && (owner_thread != thread) &&
+		(*(struct stask *volatile *) &owner_thread->t_task == owner));
+
+}
+
+/**
+ * mutex_spin : waits, with the process unlocked, for the mutex to be
+ * released, while its owner is executed by another thread; polls are
+ * separated by an exponentially growing number of idle iterations;
+ * @param mutex : the mutex to wait for;
+ * @param thread : the thread of the caller;
+ * @return the number of polls if the mutex was seen released, 0 if the spin
+ * limit was reached or if the owner stopped running;
+ */
+static usize mutex_spin(struct sched_mutex *mutex, struct sthread *thread) {
+
+	usize nb_polls;
+	usize backoff;
+	usize id;
+
+	/*Poll the mutex at most m_spin_limit times;*/
+	backoff = 1;
+	for (nb_polls = 1; nb_polls <= mutex->m_spin_limit; nb_polls++) {
+
+		/*Wait before the poll;*/
+		for (id = backoff; id--;) {
+			__sync_synchronize();
+		}
+		if (backoff < SCHED_MUTEX_BACKOFF_MAX)
+			backoff <<= 1;
+
+		/*If the mutex was released, report the number of polls;*/
+		if (!mutex_owner(mutex))
+			return nb_polls;
+
+		/*If the owner stopped running, it won't release the mutex soon;*/
+		if (!mutex_owner_running(mutex, thread))
+			return 0;
 
 	}
 
-	/*If the mutex is unlocked :*/
+	/*The spin limit was reached;*/
+	return 0;
 
-	/*Give the thread's task the ownership of the mutex;*/
-	primitive_take_ownership(&mutex->m_prim, thread->t_task);
+}
 
-	/*Make the primitive override the task;*/
-	primitive_override_task(&mutex->m_prim, thread->t_task);
-	
-	/*Complete;*/
-	return 1;
+/**
+ * sched_mutex_lock_adaptive : locks the mutex's process and attempts to lock
+ * the mutex; while the mutex's owner is executed by another thread, the
+ * process is unlocked and the thread spins with an exponential backoff, at
+ * most for the mutex's spin limit, before retrying; if the mutex can't be
+ * acquired, the task is stopped as by sched_mutex_lock; the process is
+ * unlocked on return; must be called with no lock held, between commits;
+ * @param mutex : the mutex to lock;
+ * @param thread : the thread executing the task that must lock the mutex;
+ * @return 1 if the mutex was locked, 0 if the task was stopped;
+ */
+u8 sched_mutex_lock_adaptive(
+		struct sched_mutex *mutex,
+		struct sthread *thread
+) {
+
+	struct sprocess *prc;
+	struct stask *task;
+	usize nb_polls;
+	usize limit;
+	u8 spun;
+
+	/*Args check;*/
+	ns_check(mutex);
+	ns_check(thread);
+	ns_check(thread->t_sched);
+
+	/*Fetch the process and the thread's task;*/
+	prc = mutex->m_prim.p_process;
+	task = thread->t_task;
+
+	/*Lock the process;*/
+	process_lock_thread(prc, thread);
+	spun = 0;
+
+	/*While the mutex is owned by a task executed by another thread :*/
+	while ((mutex_owner(mutex)) && (mutex_owner_running(mutex, thread))) {
+
+		/*Spin with the process unlocked;*/
+		process_unlock(prc);
+		nb_polls = mutex_spin(mutex, thread);
+		process_lock_thread(prc, thread);
+
+		/*The thread's task can't be reassigned between commits;*/
+		ns_check(thread->t_task == task);
+
+		/*Tune the spin limit : toward twice the polls of a successful spin,
+		 * half the limit after a failed one;*/
+		limit = mutex->m_spin_limit;
+		if (nb_polls) {
+			limit = limit - limit / 8 + nb_polls / 4;
+		} else {
+			limit /= 2;
+		}
+		if (limit < SCHED_MUTEX_SPIN_MIN)
+			limit = SCHED_MUTEX_SPIN_MIN;
+		if (limit > SCHED_MUTEX_SPIN_MAX)
+			limit = SCHED_MUTEX_SPIN_MAX;
+		mutex->m_spin_limit = limit;
+
+		/*If the spin failed, stop spinning;*/
+		if (!nb_polls)
+			break;
+		spun = 1;
+
+	}
+
+	/*Attempt to lock the mutex, or stop the task;*/
+	if (mutex_lock(mutex, thread)) {
+
+		/*Report the acquisition if it required to spin;*/
+		if (spun)
+			mutex->m_nb_spin_acquired++;
+
+		/*Unlock the process;*/
+		process_unlock(prc);
+		return 1;
+
+	}
+
+	/*The mutex couldn't be acquired; the task was stopped;*/
+	mutex->m_nb_parked++;
+
+	/*Unlock the process;*/
+	process_unlock(prc);
+	return 0;
 
 }
 
@@ -93,14 +335,13 @@ u8 sched_mutex_lock_nb(struct sched_mutex *mutex, struct sthread *thread) {
  * @param mutex : the mutex to unlock;
  * @param thread : the thread executing the task that must unlock the mutex;
  * @return 0 if the mutex has been unlocked, 1 if it was already unlocked,
- *  2 if the thread's task didn't own the mutex, and 3 if an ownership 
- *  release error occurred;
+ *  2 if the thread's task didn't own the mutex;
  */
 err_t sched_mutex_unlock(struct sched_mutex *mutex, struct sthread *thread) {
 
 	struct stask *task;
 	struct stask *owner;
-	err_t error;
+	usize word;
 
 	/*Args check;*/
 	ns_check(mutex);
@@ -108,7 +349,8 @@ err_t sched_mutex_unlock(struct sched_mutex *mutex, struct sthread *thread) {
 
 	/*Fetch the task and the owner of the mutex;*/
 	task = thread->t_task;
-	owner = mutex->m_prim.p_overridden;
+	word = mutex->m_owner;
+	owner = mutex_owner(mutex);
 
 	/*If the mutex is unlocked :*/
 	if (!owner) {
@@ -125,30 +367,117 @@ err_t sched_mutex_unlock(struct sched_mutex *mutex, struct sthread *thread) {
 		return 2;
 	}
 
-	/*The task owns the mutex;*/
-	
-	/*Release the ownership of the primitive;*/
-	error = primitive_release_ownership(&mutex->m_prim, task);
-	
-	/*If an error occurred during te ownership release, fail;*/
-	if (error)
-		return 3;
-	
-	/*Make the primitive unoverride the task;*/
-	primitive_unoverride_task(&mutex->m_prim);
-	
-	/*If the primitive has a stopped task :*/
-	if (!dlist_empty(&mutex->m_prim.p_stopped)) {
-		
-		/*Resume the first task;*/
-		primitive_resume_task(
-				container_of(&mutex->m_prim.p_stopped, struct stask, t_stopped)
-		);
-		
+	/*The task owns the mutex; only the task and contenders update the word;*/
+
+	/*If the mutex is not contended, release it, unless a contender came;*/
+	if ((!(word & SCHED_MUTEX_CONTENDED)) &&
+		(__sync_bool_compare_and_swap(&mutex->m_owner, word, 0))) {
+
+		/*Restore the ceiling if required;*/
+		if (mutex->m_prim.p_status & SCHED_PRIM_STATUS_CEILING)
+			primitive_ceiling_release(&mutex->m_prim);
+
+		/*Complete;*/
+		return 0;
+
+	}
+
+	/*The mutex is contended; the word can't change until it is released;*/
+
+	/*Make the primitive unoverride the task, or restore its ceiling;*/
+	if (mutex->m_prim.p_status & SCHED_PRIM_STATUS_CEILING) {
+		primitive_ceiling_release(&mutex->m_prim);
+	} else {
+		primitive_unoverride_task(&mutex->m_prim);
 	}
 
+	/*Fetch the first stopped task;*/
+	task = primitive_first_stopped(&mutex->m_prim);
+
+	/*If the primitive has a stopped task, resume it;*/
+	if (task) {
+		primitive_resume_task(task);
+	}
+
+	/*Release the mutex; keep it contended if tasks are still stopped;*/
+	__sync_synchronize();
+	mutex->m_owner = (primitive_first_stopped(&mutex->m_prim)) ?
+		SCHED_MUTEX_CONTENDED : 0;
 
 	/*Complete;*/
 	return 0;
 
 }
+
+/**
+ * sched_mutex_lock_fast : locks the mutex with a single compare and swap if it
+ * is unlocked and not contended; if not, locks the mutex's process and falls
+ * back to sched_mutex_lock; must be called with no lock held, between commits;
+ * @param mutex : the mutex to lock;
+ * @param thread : the thread executing the task that must lock the mutex;
+ * @return 1 if the mutex was locked, 0 if the task was stopped;
+ */
+u8 sched_mutex_lock_fast(struct sched_mutex *mutex, struct sthread *thread) {
+
+	struct sprocess *prc;
+	u8 locked;
+
+	/*Args check;*/
+	ns_check(mutex);
+	ns_check(thread);
+	ns_check(thread->t_sched);
+
+	/*If the mutex is free, take it; the ceiling mode requires the lock;*/
+	if ((!(mutex->m_prim.p_status & SCHED_PRIM_STATUS_CEILING)) &&
+		(__sync_bool_compare_and_swap(&mutex->m_owner, 0,
+			(usize) thread->t_task)))
+		return 1;
+
+	/*Lock the mutex or stop the task, with the process locked;*/
+	prc = mutex->m_prim.p_process;
+	process_lock_thread(prc, thread);
+	locked = mutex_lock(mutex, thread);
+	process_unlock(prc);
+
+	/*Complete;*/
+	return locked;
+
+}
+
+/**
+ * sched_mutex_unlock_fast : unlocks the mutex with a single compare and swap if
+ * it is not contended; if not, locks the mutex's process and falls back to
+ * sched_mutex_unlock; must be called with no lock held, between commits;
+ * @param mutex : the mutex to unlock;
+ * @param thread : the thread executing the task that must unlock the mutex;
+ * @return the error codes of sched_mutex_unlock;
+ */
+err_t sched_mutex_unlock_fast(
+		struct sched_mutex *mutex,
+		struct sthread *thread
+) {
+
+	struct sprocess *prc;
+	err_t error;
+
+	/*Args check;*/
+	ns_check(mutex);
+	ns_check(thread);
+	ns_check(thread->t_sched);
+
+	/*If the task owns the mutex and it is not contended, release it;*/
+	if ((!(mutex->m_prim.p_status & SCHED_PRIM_STATUS_CEILING)) &&
+		(__sync_bool_compare_and_swap(&mutex->m_owner,
+			(usize) thread->t_task, 0)))
+		return 0;
+
+	/*Unlock the mutex with the process locked;*/
+	prc = mutex->m_prim.p_process;
+	process_lock_thread(prc, thread);
+	error = sched_mutex_unlock(mutex, thread);
+	process_unlock(prc);
+
+	/*Complete;*/
+	return error;
+
+}
@@ -0,0 +1,442 @@
+/*prio.c - kerneltk - GPLV3, copyleft 2019 Raphael Outhier;*/
+
+#include <sched/prio.h>
+
+#include <check.h>
+
+
+/*------------------------------------------------------------------ internals*/
+
+/**
+ * prio_policy : determines the policy whose operations are installed in the
+ * scheduler;
+ * @param sched : the scheduler;
+ * @return the policy of @sched;
+ */
+static __inline__ struct sched_prio *prio_policy(struct scheduler *sched) {
+
+	return container_of(sched->s_ops, struct sched_prio, p_ops);
+
+}
+
+/**
+ * prio_msb : determines the index of the most significant set bit of a non
+ * null word;
+ * @param word : the word to scan, must not be null;
+ * @return the index of the most significant set bit;
+ */
+static __inline__ usize prio_msb(u32 word) {
+
+	return (usize) (SCHED_PRIO_WORD_BITS - 1 - __builtin_clz(word));
+
+}
+
+/**
+ * prio_level : determines the run queue level of a task from its effective
+ * priority;
+ * @param task : the task;
+ * @return the level of @task;
+ */
+static __inline__ usize prio_level(struct stask *task) {
+
+	usize priority;
+
+	/*Fetch the effective priority of the task;*/
+	priority = task->t_effective;
+
+	/*Priorities above the last level are scheduled in the last level;*/
+	return (priority < SCHED_PRIO_NB_LEVELS) ?
+		priority : (usize) (SCHED_PRIO_NB_LEVELS - 1);
+
+}
+
+/**
+ * prio_enqueue : inserts the task at the end of the run queue of its level,
+ * and marks the level non-empty;
+ * @param sched : the scheduler the task is registered in;
+ * @param task : the task to enqueue; must not be queued;
+ */
+static void prio_enqueue(struct scheduler *sched, struct stask *task) {
+
+	struct sched_prio *policy;
+	usize level;
+	usize word_id;
+
+	/*Fetch the policy and the level of the task;*/
+	policy = prio_policy(sched);
+	level = prio_level(task);
+	word_id = level / SCHED_PRIO_WORD_BITS;
+
+	/*Insert the task at the end of its run queue;*/
+	dlist_insert_single_before(&policy->p_queues[level], &task->t_run_list);
+	policy->p_nb_queued++;
+
+	/*Mark the level and its word non-empty;*/
+	policy->p_bitmap[word_id] |= (u32) 1 << (level % SCHED_PRIO_WORD_BITS);
+	policy->p_summary |= (u32) 1 << word_id;
+
+}
+
+/**
+ * prio_dequeue : removes the task from its run queue if it is queued;
+ * Bits of levels that become empty are cleared lazily by prio_top;
+ * @param policy : the policy the task is queued in;
+ * @param task : the task to dequeue;
+ */
+static void prio_dequeue(struct sched_prio *policy, struct stask *task) {
+
+	/*If the task is not queued, nothing to do;*/
+	if (dlist_empty(&task->t_run_list))
+		return;
+
+	/*Remove the task from its run queue;*/
+	dlist_remove(&task->t_run_list);
+	policy->p_nb_queued--;
+
+}
+
+/**
+ * prio_top : finds the first task of the most urgent non-empty level, and
+ * clears the bits of empty levels encountered;
+ * @param policy : the policy to query;
+ * @return the most urgent queued task, 0 if no task is queued;
+ */
+static struct stask *prio_top(struct sched_prio *policy) {
+
+	struct dlist *queue;
+	usize word_id;
+	usize level;
+	u32 word;
+
+	/*While a word is marked non-empty :*/
+	while (policy->p_summary) {
+
+		/*Find the most urgent marked level;*/
+		word_id = prio_msb(policy->p_summary);
+		word = policy->p_bitmap[word_id];
+		level = word_id * SCHED_PRIO_WORD_BITS + prio_msb(word);
+		queue = &policy->p_queues[level];
+
+		/*If the level holds a task, return its first task;*/
+		if (!dlist_empty(queue))
+			return container_of(queue->next, struct stask, t_run_list);
+
+		/*The level is empty; clear its bit, and its word's if required;*/
+		word &= ~((u32) 1 << (level % SCHED_PRIO_WORD_BITS));
+		policy->p_bitmap[word_id] = word;
+		if (!word)
+			policy->p_summary &= ~((u32) 1 << word_id);
+
+	}
+
+	/*No task is queued;*/
+	return 0;
+
+}
+
+/*----------------------------------------------------------- state transitions*/
+
+/*Registered and resumed tasks are queued;*/
+static void prio_queue_task(struct scheduler *sched, struct stask *task) {
+
+	prio_enqueue(sched, task);
+
+}
+
+/*Tasks resumed at once are queued in their resume order;*/
+static void prio_queue_tasks(struct scheduler *sched, struct dlist *tasks) {
+
+	struct stask *task;
+	struct dlist *save;
+
+	dlist_head_for_each_object(task, save, tasks, struct stask, t_stopped) {
+		prio_enqueue(sched, task);
+	}
+
+}
+
+/*Unregistered and stopped tasks are dequeued if they wait for a thread;*/
+static void prio_unqueue_task(struct scheduler *sched, struct stask *task) {
+
+	prio_dequeue(prio_policy(sched), task);
+
+}
+
+/*------------------------------------------------------------------ scheduling*/
+
+/*Effective priorities are reported before; nothing to do;*/
+static void prio_schedule(struct scheduler *sched) {
+
+}
+
+/**
+ * prio_assign : assigns a task to the thread, or deactivates the thread if
+ * the task is null, and reports migrations;
+ * @param policy : the policy;
+ * @param thread : the thread to assign a task to;
+ * @param task : the task to assign, may be null;
+ */
+static void prio_assign(
+	struct sched_prio *policy,
+	struct sthread *thread,
+	struct stask *task
+) {
+
+	/*If the task leaves its last thread, report the migration;*/
+	if (task && task->t_thread && (task->t_thread != thread))
+		policy->p_nb_migrations++;
+
+	/*Assign the task, or deactivate the thread;*/
+	thread_assign_task(thread, task);
+
+}
+
+/**
+ * prio_assign_one : dequeues the most urgent task and assigns it to the
+ * thread; if no task is queued, the thread is marked inactive;
+ * @param sched : the scheduler;
+ * @param thread : the thread to assign a task to;
+ * @return the assigned task, 0 if none;
+ */
+static struct stask *prio_assign_one(
+	struct scheduler *sched,
+	struct sthread *thread
+) {
+
+	struct sched_prio *policy;
+	struct stask *task;
+
+	/*Fetch the policy;*/
+	policy = prio_policy(sched);
+
+	/*Fetch and dequeue the most urgent task if any;*/
+	task = prio_top(policy);
+	if (task)
+		prio_dequeue(policy, task);
+
+	/*Assign the task;*/
+	prio_assign(policy, thread, task);
+
+	/*Return the assigned task;*/
+	return task;
+
+}
+
+/**
+ * prio_assign_all : queues back the tasks assigned to all threads, and
+ * assigns the most urgent tasks; tasks that are still warm on their last
+ * thread are assigned it first, others are assigned the remaining threads in
+ * priority order; tasks of the same level are executed in turn;
+ * @param sched : the scheduler;
+ */
+static void prio_assign_all(struct scheduler *sched) {
+
+	struct sched_prio *policy;
+	struct sthread *thread;
+	struct stask *task;
+	struct dlist *head;
+	struct dlist *save;
+	struct dlist pending;
+	usize nb_threads;
+
+	/*Fetch the policy and the head of the threads list;*/
+	policy = prio_policy(sched);
+	head = &sched->s_threads;
+
+	/*For each thread :*/
+	dlist_head_for_each_object(thread, save, head, struct sthread, t_list) {
+
+		/*If the thread's task is still active, queue it back;*/
+		task = thread->t_task;
+		if (task && (task->t_thread == thread) &&
+			(task->t_status == SCHED_STATUS_ACTIVE) &&
+			(dlist_empty(&task->t_run_list))) {
+			prio_enqueue(sched, task);
+		}
+
+	}
+
+	/*Rotate the threads list, so that the first requeued task changes at each
+	 * commit, and no task keeps precedence over its level;*/
+	if (!dlist_empty(head)) {
+		thread = container_of(head->next, struct sthread, t_list);
+		dlist_remove(&thread->t_list);
+		dlist_insert_single_before(head, &thread->t_list);
+	}
+
+	/*Dequeue the most urgent tasks, one per thread :*/
+	dlist_init(&pending);
+	for (nb_threads = sched->s_nb_threads; nb_threads--;) {
+
+		/*If no task is queued, stop;*/
+		task = prio_top(policy);
+		if (!task)
+			break;
+		prio_dequeue(policy, task);
+
+		/*Fetch the task's last thread;*/
+		thread = task->t_thread;
+
+		/*If the thread is free and the task is warm, assign it;*/
+		if (thread && (thread->t_commit != sched->s_commit_index) &&
+			(sched_task_distance(task) < policy->p_affinity_window)) {
+
+			prio_assign(policy, thread, task);
+
+		} else {
+
+			/*If not, the task waits for a remaining thread;*/
+			dlist_insert_single_before(&pending, &task->t_run_list);
+
+		}
+
+	}
+
+	/*For each thread that was not assigned a warm task :*/
+	dlist_head_for_each_object(thread, save, head, struct sthread, t_list) {
+
+		if (thread->t_commit == sched->s_commit_index)
+			continue;
+
+		/*Assign the first pending task if any, or deactivate the thread;*/
+		task = 0;
+		if (!dlist_empty(&pending)) {
+			task = container_of(pending.next, struct stask, t_run_list);
+			dlist_remove(&task->t_run_list);
+		}
+		prio_assign(policy, thread, task);
+
+	}
+
+}
+
+/*-------------------------------------------------------------- priorities*/
+
+/*Overrides are reported through effective priority updates;*/
+static void prio_override_changed(
+	struct scheduler *sched,
+	struct sprim *prim,
+	struct stask *task
+) {
+
+}
+
+/*Requeues the task at the level of its new effective priority if queued;*/
+static void prio_task_priority_updated(
+	struct scheduler *sched,
+	struct stask *task
+) {
+
+	/*If the task is not queued, it will be queued at its new level;*/
+	if (dlist_empty(&task->t_run_list))
+		return;
+
+	/*Requeue the task;*/
+	prio_dequeue(prio_policy(sched), task);
+	prio_enqueue(sched, task);
+
+}
+
+/*The priority of a task is its base priority;*/
+static usize prio_get_task_priority(struct scheduler *sched, struct stask *task) {
+
+	return task->t_priority;
+
+}
+
+/**
+ * prio_prim_get_prio : determines the priority of a primitive, as the highest
+ * effective priority of the tasks it stopped; the first stopped task of an
+ * ordered primitive has the highest one;
+ * @param prim : the primitive;
+ * @return the priority of @prim, 0 if it stopped no task;
+ */
+static usize prio_prim_get_prio(struct sprim *prim) {
+
+	struct stask *task;
+	struct dlist *head;
+	struct dlist *save;
+	usize priority;
+
+	/*If the primitive is ordered, its first stopped task is the most urgent;*/
+	if (prim->p_status & SCHED_PRIM_STATUS_ORDERED) {
+		task = primitive_first_stopped(prim);
+		return (task) ? task->t_effective : 0;
+	}
+
+	/*Fetch the head of the stopped tasks list;*/
+	head = &prim->p_stopped;
+	priority = 0;
+
+	/*Determine the highest priority of stopped tasks;*/
+	dlist_head_for_each_object(task, save, head, struct stask, t_stopped) {
+		if (task->t_effective > priority)
+			priority = task->t_effective;
+	}
+
+	/*Complete;*/
+	return priority;
+
+}
+
+/*---------------------------------------------------------------- public API*/
+
+/**
+ * sched_prio_ctor : initializes the policy and installs its operations in the
+ * scheduler; must be called before any task is registered;
+ * @param policy : the policy to initialize;
+ * @param sched : the scheduler to install the policy in;
+ */
+void sched_prio_ctor(struct sched_prio *policy, struct scheduler *sched) {
+
+	usize id;
+
+	/*Args check;*/
+	ns_check(policy);
+	ns_check(sched);
+
+	/*Initialize operations;*/
+	policy->p_ops.s_registered = &prio_queue_task;
+	policy->p_ops.s_unregistered = &prio_unqueue_task;
+	policy->p_ops.s_stopped = &prio_unqueue_task;
+	policy->p_ops.s_resumed = &prio_queue_task;
+	policy->p_ops.s_resumed_all = &prio_queue_tasks;
+	policy->p_ops.s_schedule = &prio_schedule;
+	policy->p_ops.s_assign_all = &prio_assign_all;
+	policy->p_ops.s_assign_one = &prio_assign_one;
+	policy->p_ops.s_primitive_override_taken = &prio_override_changed;
+	policy->p_ops.s_primitive_override_released = &prio_override_changed;
+	policy->p_ops.s_task_priority_updtaed = &prio_task_priority_updated;
+	policy->p_ops.s_get_task_priority = &prio_get_task_priority;
+	policy->p_ops.s_prim_get_prio = &prio_prim_get_prio;
+
+	/*Reset the bitmap and the run queues;*/
+	policy->p_summary = 0;
+	for (id = 0; id < SCHED_PRIO_NB_WORDS; id++) {
+		policy->p_bitmap[id] = 0;
+	}
+	for (id = 0; id < SCHED_PRIO_NB_LEVELS; id++) {
+		dlist_init(&policy->p_queues[id]);
+	}
+	policy->p_nb_queued = 0;
+	policy->p_affinity_window = SCHED_PRIO_AFFINITY_WINDOW;
+	policy->p_nb_migrations = 0;
+
+	/*Install the operations;*/
+	sched->s_ops = &policy->p_ops;
+
+}
+
+/**
+ * sched_prio_top : returns the most urgent queued task without dequeuing it;
+ * @param policy : the policy to query;
+ * @return the most urgent queued task, 0 if no task is queued;
+ */
+struct stask *sched_prio_top(struct sched_prio *policy) {
+
+	/*Args check;*/
+	ns_check(policy);
+
+	return prio_top(policy);
+
+}
@@ -0,0 +1,350 @@
+/*rwlock.c - kerneltk - GPLV3, copyleft 2019 Raphael Outhier;*/
+
+#include <sched/rwlock.h>
+
+#include <check.h>
+
+
+/*------------------------------------------------------------------ internals*/
+
+/**
+ * rwlock_task_slot : finds the reader slot that overrides the task;
+ * @param rwlock : the lock to search in;
+ * @param task : the task to search the slot of;
+ * @return the slot of @task, 0 if it is not a reader;
+ */
+static struct sprim *rwlock_task_slot(
+		struct sched_rwlock *rwlock,
+		struct stask *task
+) {
+
+	usize id;
+
+	/*Find the slot overriding the task;*/
+	for (id = 0; id < rwlock->r_nb_slots; id++) {
+		if (rwlock->r_slots[id].p_overridden == task)
+			return rwlock->r_slots + id;
+	}
+
+	/*The task is not a reader;*/
+	return 0;
+
+}
+
+/**
+ * rwlock_read_try : takes a reader slot for the task if no writer owns the
+ * lock, if writers don't wait while preferred, and if a slot is free;
+ * @param rwlock : the lock to read-lock;
+ * @param task : the task that must read-lock;
+ * @return 1 if the task took a slot, 0 if not;
+ */
+static u8 rwlock_read_try(struct sched_rwlock *rwlock, struct stask *task) {
+
+	struct sprim *slot;
+
+	/*If a writer owns the lock, fail;*/
+	if (rwlock->r_writer)
+		return 0;
+
+	/*If writers are preferred and wait, fail;*/
+	if ((rwlock->r_prefer_writers) && (rwlock->r_writers.nb_stopped_tasks))
+		return 0;
+
+	/*Find a free slot; if none, fail;*/
+	slot = rwlock_task_slot(rwlock, 0);
+	if (!slot)
+		return 0;
+
+	/*Give the task the ownership of the slot, and make the slot override it;*/
+	primitive_take_ownership(slot, task);
+	primitive_override_task(slot, task);
+	rwlock->r_nb_readers++;
+
+	/*Complete;*/
+	return 1;
+
+}
+
+/**
+ * rwlock_write_try : makes the task the writer if no task owns the lock;
+ * @param rwlock : the lock to write-lock;
+ * @param task : the task that must write-lock;
+ * @return 1 if the task is the writer, 0 if not;
+ */
+static u8 rwlock_write_try(struct sched_rwlock *rwlock, struct stask *task) {
+
+	/*If a writer or a reader owns the lock, fail;*/
+	if ((rwlock->r_writer) || (rwlock->r_nb_readers))
+		return 0;
+
+	/*Give the task the ownership of the lock;*/
+	primitive_take_ownership(&rwlock->r_writers, task);
+	rwlock->r_writer = task;
+
+	/*Make both primitives override the task;*/
+	primitive_override_task(&rwlock->r_writers, task);
+	primitive_override_task(&rwlock->r_readers, task);
+
+	/*Complete;*/
+	return 1;
+
+}
+
+/**
+ * rwlock_resume : resumes the tasks that may take the lock after a release;
+ * if no reader remains, the first writer is resumed, unless readers are
+ * preferred and wait; if not, readers are resumed, one per free slot, unless
+ * writers are preferred and wait;
+ * @param rwlock : the released lock;
+ */
+static void rwlock_resume(struct sched_rwlock *rwlock) {
+
+	struct stask *writer;
+	struct stask *reader;
+	usize nb_free;
+
+	/*If a writer owns the lock, nothing to do;*/
+	if (rwlock->r_writer)
+		return;
+
+	/*Fetch the first waiting writer;*/
+	writer = primitive_first_stopped(&rwlock->r_writers);
+
+	/*If it can take the lock, and is preferred or alone, resume it;*/
+	if ((writer) && (!rwlock->r_nb_readers) && ((rwlock->r_prefer_writers) ||
+		(dlist_empty(&rwlock->r_readers.p_stopped)))) {
+		primitive_resume_task(writer);
+		return;
+	}
+
+	/*If writers are preferred and wait, readers keep waiting;*/
+	if ((writer) && (rwlock->r_prefer_writers))
+		return;
+
+	/*Resume one waiting reader per free slot;*/
+	nb_free = rwlock->r_nb_slots - rwlock->r_nb_readers;
+	for (; nb_free; nb_free--) {
+		reader = primitive_first_stopped(&rwlock->r_readers);
+		if (!reader)
+			break;
+		primitive_resume_task(reader);
+	}
+
+}
+
+/*----------------------------------------------------------------- public API*/
+
+/**
+ * sched_rwlock_ctor : constructs the lock and registers its primitives to the
+ * provided process;
+ * @param rwlock : the lock to construct;
+ * @param prc : the process to register the lock to;
+ * @param slots : the reader slots;
+ * @param nb_slots : the number of reader slots, not null;
+ * @param prefer_writers : 1 if writers are preferred, 0 if readers are;
+ */
+void sched_rwlock_ctor(
+		struct sched_rwlock *rwlock,
+		struct sprocess *prc,
+		struct sprim *slots,
+		usize nb_slots,
+		u8 prefer_writers
+) {
+
+	usize id;
+
+	/*Args check;*/
+	ns_check(rwlock);
+	ns_check(prc);
+	ns_check(slots);
+	ns_check(nb_slots);
+
+	/*Register the writers and readers primitives;*/
+	process_register_prim(prc, &rwlock->r_writers);
+	process_register_prim(prc, &rwlock->r_readers);
+
+	/*Register the slots, and make them inherit the writers' priority;*/
+	for (id = 0; id < nb_slots; id++) {
+		process_register_prim(prc, slots + id);
+		primitive_inherit(slots + id, &rwlock->r_writers);
+	}
+
+	/*Initialize the lock state;*/
+	rwlock->r_slots = slots;
+	rwlock->r_nb_slots = nb_slots;
+	rwlock->r_nb_readers = 0;
+	rwlock->r_writer = 0;
+	rwlock->r_prefer_writers = prefer_writers;
+
+}
+
+/**
+ * sched_rwlock_read_lock : if the lock can be read, takes a reader slot for
+ * the thread's task; if not, stops the task and assigns a new one to the
+ * thread;
+ * @param rwlock : the lock to read-lock;
+ * @param thread : the thread executing the task that must read-lock;
+ */
+void sched_rwlock_read_lock(
+		struct sched_rwlock *rwlock,
+		struct sthread *thread
+) {
+
+	/*Args check;*/
+	ns_check(rwlock);
+	ns_check(thread);
+
+	/*If the lock can't be read, stop the thread's task;*/
+	if (!rwlock_read_try(rwlock, thread->t_task))
+		primitive_stop_thread(&rwlock->r_readers, thread);
+
+}
+
+/**
+ * sched_rwlock_read_lock_nb : non blocking read-lock function;
+ * @param rwlock : the lock to read-lock;
+ * @param thread : the thread executing the task that must read-lock;
+ * @return 1 if the locking succeeds, 0 if not;
+ */
+u8 sched_rwlock_read_lock_nb(
+		struct sched_rwlock *rwlock,
+		struct sthread *thread
+) {
+
+	/*Args check;*/
+	ns_check(rwlock);
+	ns_check(thread);
+
+	return rwlock_read_try(rwlock, thread->t_task);
+
+}
+
+/**
+ * sched_rwlock_read_unlock : releases the reader slot of the thread's task,
+ * and resumes the tasks that may take the lock;
+ * @param rwlock : the lock to read-unlock;
+ * @param thread : the thread executing the task that must read-unlock;
+ * @return 0 if the lock has been read-unlocked, 1 if the task was not a
+ * reader, and 2 if an ownership release error occurred;
+ */
+err_t sched_rwlock_read_unlock(
+		struct sched_rwlock *rwlock,
+		struct sthread *thread
+) {
+
+	struct stask *task;
+	struct sprim *slot;
+
+	/*Args check;*/
+	ns_check(rwlock);
+	ns_check(thread);
+
+	/*Fetch the task and its slot; if it has none, fail;*/
+	task = thread->t_task;
+	slot = rwlock_task_slot(rwlock, task);
+	if (!slot)
+		return 1;
+
+	/*Release the ownership of the slot; if an error occurred, fail;*/
+	if (primitive_release_ownership(slot, task))
+		return 2;
+
+	/*Free the slot;*/
+	primitive_unoverride_task(slot);
+	rwlock->r_nb_readers--;
+
+	/*Resume tasks that may take the lock;*/
+	rwlock_resume(rwlock);
+
+	/*Complete;*/
+	return 0;
+
+}
+
+/**
+ * sched_rwlock_write_lock : if the lock is free, makes the thread's task its
+ * writer; if not, stops the task and assigns a new one to the thread;
+ * @param rwlock : the lock to write-lock;
+ * @param thread : the thread executing the task that must write-lock;
+ */
+void sched_rwlock_write_lock(
+		struct sched_rwlock *rwlock,
+		struct sthread *thread
+) {
+
+	/*Args check;*/
+	ns_check(rwlock);
+	ns_check(thread);
+
+	/*If the lock is owned, stop the thread's task;*/
+	if (!rwlock_write_try(rwlock, thread->t_task))
+		primitive_stop_thread(&rwlock->r_writers, thread);
+
+}
+
+/**
+ * sched_rwlock_write_lock_nb : non blocking write-lock function;
+ * @param rwlock : the lock to write-lock;
+ * @param thread : the thread executing the task that must write-lock;
+ * @return 1 if the locking succeeds, 0 if not;
+ */
+u8 sched_rwlock_write_lock_nb(
+		struct sched_rwlock *rwlock,
+		struct sthread *thread
+) {
+
+	/*Args check;*/
+	ns_check(rwlock);
+	ns_check(thread);
+
+	return rwlock_write_try(rwlock, thread->t_task);
+
+}
+
+/**
+ * sched_rwlock_write_unlock : releases the writer of the lock, and resumes
+ * the tasks that may take the lock;
+ * @param rwlock : the lock to write-unlock;
+ * @param thread : the thread executing the task that must write-unlock;
+ * @return 0 if the lock has been write-unlocked, 1 if it was not
+ * write-locked, 2 if the thread's task was not the writer, and 3 if an
+ * ownership release error occurred;
+ */
+err_t sched_rwlock_write_unlock(
+		struct sched_rwlock *rwlock,
+		struct sthread *thread
+) {
+
+	struct stask *task;
+
+	/*Args check;*/
+	ns_check(rwlock);
+	ns_check(thread);
+
+	/*Fetch the thread's task;*/
+	task = thread->t_task;
+
+	/*If the lock is not write-locked, fail;*/
+	if (!rwlock->r_writer)
+		return 1;
+
+	/*If the task is not the writer, fail;*/
+	if (rwlock->r_writer != task)
+		return 2;
+
+	/*Release the ownership of the lock; if an error occurred, fail;*/
+	if (primitive_release_ownership(&rwlock->r_writers, task))
+		return 3;
+
+	/*Make both primitives unoverride the task;*/
+	primitive_unoverride_task(&rwlock->r_writers);
+	primitive_unoverride_task(&rwlock->r_readers);
+	rwlock->r_writer = 0;
+
+	/*Resume tasks that may take the lock;*/
+	rwlock_resume(rwlock);
+
+	/*Complete;*/
+	return 0;
+
+}
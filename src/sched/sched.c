@@ -3,7 +3,6 @@
 #include <sched/sched.h>
 
 
-#include <spinlock.h>
 #include <check.h>
 
 
@@ -25,101 +24,1188 @@ static __inline__ u8 thread_active(struct sthread *proc) {
 }
 
 
+/*---------------------------------------------------------------------- locks*/
+
+/**
+ * lock_node_init : initializes a queue node, unqueued;
+ * @param node : the node to initialize;
+ */
+static __inline__ void lock_node_init(struct sched_lock_node *node) {
+
+	node->n_next = 0;
+	node->n_waiting = 0;
+
+}
+
+/**
+ * lock_init : initializes a free lock;
+ * @param lock : the lock to initialize;
+ */
+static void lock_init(struct sched_lock *lock) {
+
+	lock->l_tail = 0;
+	lock->l_holder = 0;
+	lock_node_init(&lock->l_try_node);
+	lock->l_nb_acquired = 0;
+	lock->l_nb_contended = 0;
+	lock->l_nb_failed = 0;
+
+}
+
+/**
+ * lock_try : attempts to take the lock, if its queue is empty;
+ * @param lock : the lock to take;
+ * @return 1 if the lock was taken, 0 if it was held;
+ */
+static u8 lock_try(struct sched_lock *lock) {
+
+	/*If the queue is not empty, fail;*/
+	if ((lock->l_tail) || (!__sync_bool_compare_and_swap(&lock->l_tail,
+		(struct sched_lock_node *) 0, &lock->l_try_node))) {
+
+		__sync_fetch_and_add(&lock->l_nb_failed, 1);
+		return 0;
+
+	}
+
+	/*We hold the lock; the try node's link was cleared by its last holder;*/
+	lock->l_holder = &lock->l_try_node;
+	lock->l_nb_acquired++;
+
+	/*Complete;*/
+	return 1;
+
+}
+
+/**
+ * lock_wait : takes the lock, waiting in its queue until the previous holders
+ * released it;
+ * @param lock : the lock to take;
+ * @param node : the caller's queue node;
+ */
+static void lock_wait(struct sched_lock *lock, struct sched_lock_node *node) {
+
+	struct sched_lock_node *prev;
+
+	/*Initialize the node;*/
+	node->n_next = 0;
+	node->n_waiting = 1;
+
+	/*Queue the node;*/
+	do {
+		prev = lock->l_tail;
+	} while (!__sync_bool_compare_and_swap(&lock->l_tail, prev, node));
+
+	/*If the lock is held, link to the predecessor and wait for the hand off;*/
+	if (prev) {
+
+		prev->n_next = node;
+		while (node->n_waiting) {
+		}
+
+		/*Order the critical section after the hand off;*/
+		__sync_synchronize();
+
+		/*Report the contention;*/
+		lock->l_nb_contended++;
+
+	}
+
+	/*We hold the lock;*/
+	lock->l_holder = node;
+	lock->l_nb_acquired++;
+
+}
+
+/**
+ * lock_release : releases the lock, and hands it off to the first waiter if
+ * any;
+ * @param lock : the held lock to release;
+ */
+static void lock_release(struct sched_lock *lock) {
+
+	struct sched_lock_node *node;
+	struct sched_lock_node *next;
+
+	/*Fetch the holder's node;*/
+	node = lock->l_holder;
+	ns_check(node);
+	ns_check(lock->l_tail);
+
+	/*If no waiter is linked :*/
+	next = node->n_next;
+	if (!next) {
+
+		/*If no waiter is queued, free the lock;*/
+		if (__sync_bool_compare_and_swap(&lock->l_tail, node,
+			(struct sched_lock_node *) 0))
+			return;
+
+		/*A waiter is queued; wait until it links to the node;*/
+		while (!(next = node->n_next)) {
+		}
+
+	}
+
+	/*Clear the link, so that the node can be queued again;*/
+	node->n_next = 0;
+
+	/*Order the critical section before the hand off, and hand off;*/
+	__sync_synchronize();
+	next->n_waiting = 0;
+
+}
+
+/**
+ * process_enter_sched : locks the scheduler of the process, whose lock is
+ * held, with the process's node, unless the holder of the process lock
+ * already holds the scheduler lock;
+ * @param prc : the locked process;
+ */
+static void process_enter_sched(struct sprocess *prc) {
+
+	/*If the scheduler is not held, lock it;*/
+	if (!prc->p_sched_held)
+		lock_wait(&prc->p_sched->s_lock, &prc->p_sched_node);
+
+}
+
+/**
+ * process_leave_sched : unlocks the scheduler locked by process_enter_sched;
+ * @param prc : the locked process;
+ */
+static void process_leave_sched(struct sprocess *prc) {
+
+	/*If the scheduler was locked by process_enter_sched, unlock it;*/
+	if (!prc->p_sched_held)
+		lock_release(&prc->p_sched->s_lock);
+
+}
+
+/**
+ * process_commit_lock : attempts to lock the process for the committer, that
+ * holds the scheduler lock; as process locks are taken before the scheduler
+ * lock, the committer never waits for them; if the process is held, it is
+ * marked deferred, so that its holder applies the work of the commit when it
+ * unlocks it;
+ * @param prc : the process to lock;
+ * @return 1 if the process was locked, 0 if it is held;
+ */
+static u8 process_commit_lock(struct sprocess *prc) {
+
+	/*Attempt to lock the process; if it is held, defer the work;*/
+	if (!lock_try(&prc->p_lock)) {
+		prc->p_deferred = 1;
+		return 0;
+	}
+
+	/*The scheduler lock is held;*/
+	prc->p_sched_held = 1;
+
+	/*Complete;*/
+	return 1;
+
+}
+
+/**
+ * process_commit_unlock : unlocks the process locked by process_commit_lock;
+ * @param prc : the locked process;
+ */
+static void process_commit_unlock(struct sprocess *prc) {
+
+	prc->p_sched_held = 0;
+	lock_release(&prc->p_lock);
+
+}
+
+/**
+ * process_hold_sched : marks the scheduler held by the holder of the process
+ * lock, that locked the process before the scheduler;
+ * @param prc : the locked process;
+ * @param held : 1 if the scheduler lock is held, 0 if it is released;
+ */
+static __inline__ void process_hold_sched(struct sprocess *prc, u8 held) {
+
+	/*Check that the process is locked;*/
+	ns_check(prc->p_lock.l_tail != 0);
+
+	prc->p_sched_held = held;
+
+}
+
+
 /*--------------------------------------------------------- update propagation*/
 
 /**
- * task_propagate_update : marks the task and its parents in the
- * tasks-primitives ownership tree, until an object that is marked updated is
- * encountered, or the root of the tree is reached;
- * @param task : the task that is to be marked updated;
+ * task_propagate_update : marks the task and its parents in the
+ * tasks-primitives ownership tree, until an object that is marked updated is
+ * encountered, or the root of the tree is reached;
+ * @param task : the task that is to be marked updated;
+ */
+static void task_propagate_update(struct stask *task) {
+
+	struct sprocess *prc;
+	struct sprim *prim;
+
+	/*Fetch the process, common to all objects of the tree;*/
+	prc = task->t_process;
+
+	while (1) {
+
+		/*If the task is already marked updated :*/
+		if (task->t_flags & STASK_STATUS_UPDATED) {
+			break;
+		}
+
+		/*Mark the task updated;*/
+		task->t_flags |= STASK_STATUS_UPDATED;
+		dlist_insert_single_before(&prc->p_dirty_tasks, &task->t_dirty);
+
+		/*Fetch the task's owner;*/
+		prim = task->t_stopper;
+
+		/*If the task has no owner, complete;*/
+		if (!prim)
+			break;
+
+
+		/*If the primitive is already marked updated, complete*/
+		if (prim->p_status & SCHED_PRIM_STATUS_UPDATED) {
+			break;
+		}
+
+		/*Mark the primitive updated;*/
+		prim->p_status |= SCHED_PRIM_STATUS_UPDATED;
+		dlist_insert_single_before(&prc->p_dirty_prims, &prim->p_dirty);
+
+		/*Fetch the primitive's overridden task;*/
+		task = prim->p_overridden;
+
+		/*If the primitive has no owner, complete;*/
+		if (!task)
+			break;
+
+	}
+
+}
+
+/**
+ * primitive_propagate_update : marks the primitive and its parents in the
+ * tasks-primitives ownership tree, until an object that is marked updated is
+ * encountered, or the root of the tree is reached;
+ * @param prim : the primitive that is to be marked updated;
+ */
+static void primitive_propagate_update(struct sprim *prim) {
+
+	struct sprocess *prc;
+	struct stask *task;
+
+	/*Fetch the process, common to all objects of the tree;*/
+	prc = prim->p_process;
+
+	while (1) {
+
+		/*If the primitive is already marked updated, complete*/
+		if (prim->p_status & SCHED_PRIM_STATUS_UPDATED) {
+			break;
+		}
+
+		/*Mark the primitive updated;*/
+		prim->p_status |= SCHED_PRIM_STATUS_UPDATED;
+		dlist_insert_single_before(&prc->p_dirty_prims, &prim->p_dirty);
+
+		/*Fetch the primitive's overridden task;*/
+		task = prim->p_overridden;
+
+		/*If the primitive has no owner, complete;*/
+		if (!task)
+			break;
+
+		/*If the task is already marked updated :*/
+		if (task->t_flags & STASK_STATUS_UPDATED) {
+			break;
+		}
+
+		/*Mark the task updated;*/
+		task->t_flags |= STASK_STATUS_UPDATED;
+		dlist_insert_single_before(&prc->p_dirty_tasks, &task->t_dirty);
+
+		/*Fetch the task's owner;*/
+		prim = task->t_stopper;
+
+		/*If the task has no owner, complete;*/
+		if (!prim)
+			break;
+
+	}
+}
+
+
+/*------------------------------------------------------------ overriders heap*/
+
+/**
+ * heap_meld : melds two pairing heaps of primitives; the root of lower
+ * priority becomes the first child of the other;
+ * @param a : the root of the first heap, may be null;
+ * @param b : the root of the second heap, may be null;
+ * @return the root of the melded heap;
+ */
+static struct sprim *heap_meld(struct sprim *a, struct sprim *b) {
+
+	struct sprim *tmp;
+
+	/*If one heap is empty, return the other;*/
+	if (!a)
+		return b;
+	if (!b)
+		return a;
+
+	/*Keep the root of highest priority in @a;*/
+	if (b->p_priority > a->p_priority) {
+		tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	/*Insert @b as the first child of @a;*/
+	b->p_heap_prev = a;
+	b->p_heap_next = a->p_heap_child;
+	if (a->p_heap_child)
+		a->p_heap_child->p_heap_prev = b;
+	a->p_heap_child = b;
+
+	/*Complete;*/
+	return a;
+
+}
+
+/**
+ * heap_merge_pairs : melds a list of sibling heaps in two passes; siblings
+ * are melded by pairs from the first to the last, then the pairs are melded
+ * from the last to the first;
+ * @param first : the first sibling, may be null;
+ * @return the root of the melded heap;
+ */
+static struct sprim *heap_merge_pairs(struct sprim *first) {
+
+	struct sprim *pairs;
+	struct sprim *next;
+	struct sprim *a;
+	struct sprim *b;
+
+	/*Meld siblings by pairs, and stack pairs through their next field;*/
+	pairs = 0;
+	while (first) {
+
+		/*Detach the two first siblings;*/
+		a = first;
+		b = a->p_heap_next;
+		next = (b) ? b->p_heap_next : 0;
+		a->p_heap_next = a->p_heap_prev = 0;
+		if (b)
+			b->p_heap_next = b->p_heap_prev = 0;
+
+		/*Meld them and stack the pair;*/
+		a = heap_meld(a, b);
+		a->p_heap_next = pairs;
+		pairs = a;
+
+		first = next;
+
+	}
+
+	/*Meld stacked pairs, from the last one to the first one;*/
+	while (pairs) {
+		next = pairs->p_heap_next;
+		pairs->p_heap_next = 0;
+		first = heap_meld(first, pairs);
+		pairs = next;
+	}
+
+	/*Complete;*/
+	return first;
+
+}
+
+/**
+ * heap_cut : detaches a non-root primitive and its sub-heap from its parent
+ * and siblings;
+ * @param prim : the primitive to detach;
+ */
+static void heap_cut(struct sprim *prim) {
+
+	struct sprim *prev;
+
+	/*Fetch the previous sibling or the parent;*/
+	prev = prim->p_heap_prev;
+
+	/*Unlink the primitive from its predecessor;*/
+	if (prev->p_heap_child == prim) {
+		prev->p_heap_child = prim->p_heap_next;
+	} else {
+		prev->p_heap_next = prim->p_heap_next;
+	}
+
+	/*Unlink the primitive from its successor;*/
+	if (prim->p_heap_next)
+		prim->p_heap_next->p_heap_prev = prev;
+
+	/*Reset sibling links;*/
+	prim->p_heap_next = prim->p_heap_prev = 0;
+
+}
+
+/**
+ * heap_insert : inserts the primitive in the overriders heap of the task;
+ * @param task : the task the primitive overrides;
+ * @param prim : the primitive to insert;
+ */
+static void heap_insert(struct stask *task, struct sprim *prim) {
+
+	/*Reset heap links;*/
+	prim->p_heap_child = prim->p_heap_next = prim->p_heap_prev = 0;
+
+	/*Meld the primitive with the heap;*/
+	task->t_overriders_heap = heap_meld(task->t_overriders_heap, prim);
+
+}
+
+/**
+ * heap_remove : removes the primitive from the overriders heap of the task;
+ * @param task : the task the primitive overrides;
+ * @param prim : the primitive to remove;
+ */
+static void heap_remove(struct stask *task, struct sprim *prim) {
+
+	struct sprim *children;
+
+	/*Meld the children of the primitive;*/
+	children = heap_merge_pairs(prim->p_heap_child);
+	prim->p_heap_child = 0;
+
+	/*If the primitive is the root, its children replace it;*/
+	if (task->t_overriders_heap == prim) {
+
+		task->t_overriders_heap = children;
+
+	} else {
+
+		/*If not, detach it and meld its children with the heap;*/
+		heap_cut(prim);
+		task->t_overriders_heap = heap_meld(task->t_overriders_heap, children);
+
+	}
+
+}
+
+/**
+ * heap_update : restores the position of the primitive in the overriders
+ * heap of the task, after its priority changed;
+ * @param task : the task the primitive overrides;
+ * @param prim : the primitive whose priority changed;
+ * @param old_priority : the previous priority of the primitive;
+ */
+static void heap_update(
+		struct stask *task,
+		struct sprim *prim,
+		usize old_priority
+) {
+
+	/*If the priority increased :*/
+	if (prim->p_priority > old_priority) {
+
+		/*If the primitive is not the root, meld its sub-heap with the heap;*/
+		if (task->t_overriders_heap != prim) {
+			heap_cut(prim);
+			task->t_overriders_heap = heap_meld(task->t_overriders_heap, prim);
+		}
+
+	} else {
+
+		/*If the priority decreased, reinsert the primitive;*/
+		heap_remove(task, prim);
+		heap_insert(task, prim);
+
+	}
+
+}
+
+/*------------------------------------------------------------- stopped lists*/
+
+/**
+ * primitive_insert_stopped : inserts the task in the primitive's stopped list;
+ * if the primitive is ordered, the task is inserted after the tasks of higher
+ * or equal effective priority; if not, it is inserted at the end;
+ * @param prim : the primitive that stopped the task;
+ * @param task : the task to insert;
+ */
+static void primitive_insert_stopped(struct sprim *prim, struct stask *task) {
+
+	struct dlist *node;
+
+	/*Start from the end of the list;*/
+	node = prim->p_stopped.prev;
+
+	/*If the primitive is ordered, skip tasks of lower priority backwards;*/
+	if (prim->p_status & SCHED_PRIM_STATUS_ORDERED) {
+		while ((node != &prim->p_stopped) &&
+			(container_of(node, struct stask, t_stopped)->t_effective <
+				task->t_effective)) {
+			node = node->prev;
+		}
+	}
+
+	/*Insert the task after the node;*/
+	dlist_insert_single_after(node, &task->t_stopped);
+
+}
+
+/*------------------------------------------------------- priority recomputation*/
+
+/**
+ * primitive_update_priority : recomputes the priority of the primitive;
+ * @param sched : the scheduler of the primitive;
+ * @param prim : the primitive to update;
+ * @return 1 if the priority changed, 0 if not;
+ */
+static u8 primitive_update_priority(struct scheduler *sched, struct sprim *prim) {
+
+	usize priority;
+	usize old_priority;
+
+	/*Determine the priority of the primitive;*/
+	priority = (*(sched->s_ops->s_prim_get_prio))(prim);
+
+	/*If the source of the primitive has a higher priority, inherit it;*/
+	if ((prim->p_source) && (prim->p_source->p_priority > priority))
+		priority = prim->p_source->p_priority;
+
+	/*If the priority didn't change, complete;*/
+	old_priority = prim->p_priority;
+	if (priority == old_priority)
+		return 0;
+
+	/*Update the priority;*/
+	prim->p_priority = priority;
+
+	/*If the primitive overrides a task, update its overriders heap;*/
+	if (prim->p_overridden)
+		heap_update(prim->p_overridden, prim, old_priority);
+
+	/*Complete;*/
+	return 1;
+
+}
+
+/**
+ * task_update_priority : recomputes the effective priority of the task, from
+ * its base priority, its ceiling, and the priority of the root of its
+ * overriders heap, and reports it to the implementation if it changed;
+ * @param sched : the scheduler of the task;
+ * @param task : the task to update;
+ * @return 1 if the effective priority changed, 0 if not;
+ */
+static u8 task_update_priority(struct scheduler *sched, struct stask *task) {
+
+	struct sprim *prim;
+	usize priority;
+
+	/*Fetch the base priority of the task;*/
+	priority = (*(sched->s_ops->s_get_task_priority))(sched, task);
+
+	/*The effective priority is the maximal one of overriders and task;*/
+	prim = task->t_overriders_heap;
+	if ((prim) && (prim->p_priority > priority))
+		priority = prim->p_priority;
+
+	/*The task is raised to its ceiling;*/
+	if (task->t_ceiling > priority)
+		priority = task->t_ceiling;
+
+	/*If the effective priority didn't change, complete;*/
+	if (priority == task->t_effective)
+		return 0;
+
+	/*Update the effective priority;*/
+	task->t_effective = priority;
+
+	/*If the task is stopped by an ordered primitive, reposition it;*/
+	prim = task->t_stopper;
+	if ((prim) && (prim->p_status & SCHED_PRIM_STATUS_ORDERED)) {
+		dlist_remove(&task->t_stopped);
+		primitive_insert_stopped(prim, task);
+	}
+
+	/*Report the effective priority;*/
+	sched->s_nb_priority_updates++;
+	(*(sched->s_ops->s_task_priority_updtaed))(sched, task);
+
+	/*Complete;*/
+	return 1;
+
+}
+
+/*Inheritors propagate their changes to their overridden tasks;*/
+static void primitive_propagate_inheritors(
+		struct scheduler *sched,
+		struct sprim *prim
+);
+
+/**
+ * task_propagate_priority : recomputes the priority of the task, and while
+ * the priority of the recomputed object changes, the ones of its parents in
+ * the tasks-primitives ownership tree;
+ * @param sched : the scheduler of the task;
+ * @param task : the task to recompute the priority of;
+ */
+static void task_propagate_priority(struct scheduler *sched, struct stask *task) {
+
+	struct sprim *prim;
+
+	while (task_update_priority(sched, task)) {
+
+		/*Fetch the task's stopper;*/
+		prim = task->t_stopper;
+
+		/*If the task is not stopped, or if its stopper's priority didn't
+		 * change, complete;*/
+		if ((!prim) || (!primitive_update_priority(sched, prim)))
+			break;
+
+		/*Propagate the change to the primitive's inheritors;*/
+		primitive_propagate_inheritors(sched, prim);
+
+		/*Fetch the primitive's overridden task;*/
+		task = prim->p_overridden;
+
+		/*If the primitive overrides no task, complete;*/
+		if (!task)
+			break;
+
+	}
+
+}
+
+/**
+ * primitive_propagate_inheritors : recomputes the priorities of the
+ * primitives inheriting the one of the primitive, and propagates their changes
+ * to their own inheritors and overridden tasks;
+ * @param sched : the scheduler of the primitive;
+ * @param prim : the primitive whose priority changed;
+ */
+static void primitive_propagate_inheritors(
+		struct scheduler *sched,
+		struct sprim *prim
+) {
+
+	struct sprim *inheritor;
+	struct dlist *head;
+	struct dlist *save;
+
+	/*Fetch the head of the inheritors list;*/
+	head = &prim->p_inheritors;
+
+	/*For each inheritor whose priority changes :*/
+	dlist_head_for_each_object(inheritor, save, head, struct sprim,
+		p_inherit_list) {
+
+		if (!primitive_update_priority(sched, inheritor))
+			continue;
+
+		/*Propagate the change to its inheritors and overridden task;*/
+		primitive_propagate_inheritors(sched, inheritor);
+		if (inheritor->p_overridden)
+			task_propagate_priority(sched, inheritor->p_overridden);
+
+	}
+
+}
+
+/**
+ * process_update_priorities : recomputes the priorities of all objects of the
+ * process marked updated since the last commit close, and resets their marks;
+ * a changed priority is propagated to the parents of the object, so that the
+ * order in which marked objects are processed doesn't matter; the process and
+ * the scheduler must be locked;
+ * @param sched : the scheduler of the process;
+ * @param prc : the process to update;
+ */
+static void process_update_priorities(
+		struct scheduler *sched,
+		struct sprocess *prc
+) {
+
+	struct sprim *prim;
+	struct stask *task;
+
+	/*For each primitive marked updated :*/
+	while (!dlist_empty(&prc->p_dirty_prims)) {
+
+		/*Fetch the primitive and reset its mark;*/
+		prim = container_of(prc->p_dirty_prims.next, struct sprim, p_dirty);
+		dlist_remove(&prim->p_dirty);
+		prim->p_status &= ~SCHED_PRIM_STATUS_UPDATED;
+
+		/*Update its priority;*/
+		if (!primitive_update_priority(sched, prim))
+			continue;
+
+		/*Propagate the change to its inheritors and owner;*/
+		primitive_propagate_inheritors(sched, prim);
+		if (prim->p_overridden)
+			task_propagate_priority(sched, prim->p_overridden);
+
+	}
+
+	/*For each task marked updated :*/
+	while (!dlist_empty(&prc->p_dirty_tasks)) {
+
+		/*Fetch the task and reset its mark;*/
+		task = container_of(prc->p_dirty_tasks.next, struct stask, t_dirty);
+		dlist_remove(&task->t_dirty);
+		task->t_flags &= ~STASK_STATUS_UPDATED;
+
+		/*Update its priority and propagate the change;*/
+		task_propagate_priority(sched, task);
+
+	}
+
+}
+
+/**
+ * sched_update_priorities : recomputes the priorities of all objects marked
+ * updated since the last commit close, process by process, as the
+ * tasks-primitives tree never spans several processes; the marks of a process
+ * whose lock is held are applied by its holder when it unlocks it;
+ * @param sched : the scheduler to update;
  */
-static void task_propagate_update(struct stask *task) {
+static void sched_update_priorities(struct scheduler *sched) {
 
-	struct sprim *prim;
+	struct sprocess *prc;
+	struct dlist *save;
 
-	while (1) {
+	/*Update each process that can be locked;*/
+	dlist_head_for_each_object(prc, save, &sched->s_processes,
+		struct sprocess, p_list) {
+		if (!process_commit_lock(prc))
+			continue;
+		process_update_priorities(sched, prc);
+		process_commit_unlock(prc);
+	}
 
-		/*If the task is already marked updated :*/
-		if (task->t_status & STASK_STATUS_UPDATED) {
-			break;
-		}
+}
 
-		/*Mark the task updated;*/
-		task->t_status |= STASK_STATUS_UPDATED;
+/*------------------------------------------------------------------- journals*/
 
-		/*Fetch the task's owner;*/
-		prim = task->t_stopper;
+/**
+ * task_listed : determines whether the task is referenced in the scheduler's
+ * active list;
+ * @param task : the registered task;
+ * @return 1 if the task is in the active list, 0 if not;
+ */
+static __inline__ u8 task_listed(struct stask *task) {
 
-		/*If the task has no owner, complete;*/
-		if (!prim)
-			break;
+	/*A journaled task's listing is the one it had when first journaled;*/
+	if (task->t_flags & STASK_STATUS_JOURNALED)
+		return (u8) ((task->t_flags & STASK_STATUS_LISTED) != 0);
 
+	return (u8) (task->t_status == SCHED_STATUS_ACTIVE);
 
-		/*If the primitive is already marked updated, complete*/
-		if (prim->p_status & SCHED_PRIM_STATUS_UPDATED) {
-			break;
+}
+
+/**
+ * task_journal : if the task is journaled, or if its process is locked by a
+ * thread in journal mode, records its new activity in the process's journal,
+ * without updating the active list or the implementation; the process must be
+ * locked;
+ * @param task : the task whose activity changes;
+ * @param active : 1 if the task is resumed, 0 if it is stopped;
+ * @return 1 if the change was journaled, 0 if the scheduler must be updated;
+ */
+static u8 task_journal(struct stask *task, u8 active) {
+
+	/*If the task is not journaled yet :*/
+	if (!(task->t_flags & STASK_STATUS_JOURNALED)) {
+
+		/*If the process is not locked in journal mode, fail;*/
+		if (!task->t_process->p_journaling)
+			return 0;
+
+		/*Reference the task in the process's journal, with its listing;*/
+		task->t_flags |= STASK_STATUS_JOURNALED;
+		if (task->t_status == SCHED_STATUS_ACTIVE) {
+			task->t_flags |= STASK_STATUS_LISTED;
+		} else {
+			task->t_flags &= ~STASK_STATUS_LISTED;
 		}
+		dlist_insert_single_before(&task->t_process->p_journal,
+			&task->t_journal);
 
-		/*Mark the primitive updated;*/
-		prim->p_status |= SCHED_PRIM_STATUS_UPDATED;
+	}
 
-		/*Fetch the primitive's overridden task;*/
-		task = prim->p_overridden;
+	/*Update the activity of the task; the listing is fixed at merge;*/
+	task->t_status = (active) ? SCHED_STATUS_ACTIVE : SCHED_STATUS_STOPPED;
 
-		/*If the primitive has no owner, complete;*/
-		if (!task)
-			break;
+	/*Complete;*/
+	return 1;
+
+}
+
+/**
+ * task_unjournal : removes the task from its process's journal if any, and
+ * forgets its listing; the process must be locked;
+ * @param task : the task to remove;
+ */
+static void task_unjournal(struct stask *task) {
+
+	dlist_remove(&task->t_journal);
+	task->t_flags &= ~(STASK_STATUS_JOURNALED | STASK_STATUS_LISTED);
+
+}
+
+/**
+ * process_merge_journal : empties the process's journal, and updates the
+ * active list according to the activity of each journaled task; stopped tasks
+ * are reported at once, resumed tasks are appended to the provided list,
+ * linked by their stopped links; the process and the scheduler must be
+ * locked;
+ * @param sched : the scheduler of the process;
+ * @param prc : the process whose journal must be merged;
+ * @param resumed : the list to append resumed tasks to;
+ */
+static void process_merge_journal(
+		struct scheduler *sched,
+		struct sprocess *prc,
+		struct dlist *resumed
+) {
+
+	struct stask *task;
+	u8 listed;
+
+	/*For each journaled task :*/
+	while (!dlist_empty(&prc->p_journal)) {
+
+		/*Fetch the task, its listing, and remove it from the journal;*/
+		task = container_of(prc->p_journal.next, struct stask, t_journal);
+		listed = task_listed(task);
+		task_unjournal(task);
+		sched->s_nb_journaled++;
+
+		/*If the task was stopped, remove it and report it;*/
+		if ((listed) && (task->t_status == SCHED_STATUS_STOPPED)) {
+			dlist_remove(&task->t_sched_list);
+			(*(sched->s_ops->s_stopped))(sched, task);
+		}
+
+		/*If the task was resumed, insert it and keep it to report it;*/
+		if ((!listed) && (task->t_status == SCHED_STATUS_ACTIVE)) {
+			dlist_insert_single_after(&sched->s_actives, &task->t_sched_list);
+			dlist_insert_single_before(resumed, &task->t_stopped);
+		}
 
 	}
 
 }
 
 /**
- * primitive_propagate_update : marks the primitive and its parents in the
- * tasks-primitives ownership tree, until an object that is marked updated is
- * encountered, or the root of the tree is reached;
- * @param prim : the primitive that is to be marked updated;
+ * sched_report_resumed : notifies the implementation of the tasks of the
+ * list, linked by their stopped links, at once if it supports it, and resets
+ * their links;
+ * @param sched : the scheduler;
+ * @param resumed : the list of resumed tasks;
  */
-static void primitive_propagate_update(struct sprim *prim) {
+static void sched_report_resumed(struct scheduler *sched, struct dlist *resumed) {
 
 	struct stask *task;
+	struct dlist *save;
 
-	while (1) {
+	/*If no task was resumed, complete;*/
+	if (dlist_empty(resumed))
+		return;
 
-		/*If the primitive is already marked updated, complete*/
-		if (prim->p_status & SCHED_PRIM_STATUS_UPDATED) {
-			break;
+	/*Notify the implementation, at once if supported;*/
+	if (sched->s_ops->s_resumed_all) {
+		(*(sched->s_ops->s_resumed_all))(sched, resumed);
+	} else {
+		dlist_head_for_each_object(task, save, resumed, struct stask,
+			t_stopped) {
+			(*(sched->s_ops->s_resumed))(sched, task);
 		}
+	}
 
-		/*Mark the primitive updated;*/
-		prim->p_status |= SCHED_PRIM_STATUS_UPDATED;
+	/*Reset the stopped links of resumed tasks;*/
+	while (!dlist_empty(resumed)) {
+		dlist_remove(resumed->next);
+	}
 
-		/*Fetch the primitive's overridden task;*/
-		task = prim->p_overridden;
+}
 
-		/*If the primitive has no owner, complete;*/
-		if (!task)
-			break;
+/**
+ * sched_merge_journals : merges the journal of each process whose lock is
+ * free, and notifies the implementation of its resumed tasks at once, while
+ * the process is locked; journals of processes whose lock is held are merged
+ * by their holders when they unlock them;
+ * @param sched : the scheduler to update;
+ */
+static void sched_merge_journals(struct scheduler *sched) {
 
-		/*If the task is already marked updated :*/
-		if (task->t_status & STASK_STATUS_UPDATED) {
-			break;
+	struct sprocess *prc;
+	struct dlist *save;
+	struct dlist resumed;
+
+	/*Merge the journal of each process that can be locked;*/
+	dlist_init(&resumed);
+	dlist_head_for_each_object(prc, save, &sched->s_processes,
+		struct sprocess, p_list) {
+		if (!process_commit_lock(prc))
+			continue;
+		process_merge_journal(sched, prc, &resumed);
+		sched_report_resumed(sched, &resumed);
+		process_commit_unlock(prc);
+	}
+
+}
+
+/*------------------------------------------------------------ posted resumes*/
+
+/**
+ * sched_push_posted : pushes the task, whose post is claimed, in the
+ * scheduler's posted stack;
+ * @param sched : the scheduler;
+ * @param task : the posted task;
+ */
+static void sched_push_posted(struct scheduler *sched, struct stask *task) {
+
+	struct stask *head;
+
+	do {
+		head = sched->s_posted;
+		task->t_post_next = head;
+	} while (!__sync_bool_compare_and_swap(&sched->s_posted, head, task));
+
+}
+
+/**
+ * sched_take_posted : takes the whole posted stack of the scheduler, and
+ * reverses it, so that tasks are in their posting order; as the stack is only
+ * pushed, and taken as a whole, it is not subject to ABA;
+ * @param sched : the scheduler;
+ * @return the first posted task, 0 if none;
+ */
+static struct stask *sched_take_posted(struct scheduler *sched) {
+
+	struct stask *head;
+	struct stask *next;
+	struct stask *first;
+
+	/*Take the stack;*/
+	do {
+		head = sched->s_posted;
+		if (!head)
+			return 0;
+	} while (!__sync_bool_compare_and_swap(&sched->s_posted, head, 0));
+
+	/*Reverse it;*/
+	first = 0;
+	while (head) {
+		next = head->t_post_next;
+		head->t_post_next = first;
+		first = head;
+		head = next;
+	}
+
+	/*Complete;*/
+	return first;
+
+}
+
+/**
+ * task_resume_posted : releases the posted resume of the task, and resumes
+ * the task if it is still stopped by the expected primitive; the process must
+ * be locked, or a commit opened;
+ * @param task : the posted task;
+ * @return 1 if the task was resumed, 0 if not;
+ */
+static u8 task_resume_posted(struct stask *task) {
+
+	struct sprim *prim;
+
+	/*Fetch the expected primitive, and release the post; as the process is
+	 * locked, the task can't be stopped again before it is resumed;*/
+	prim = task->t_post_prim;
+	task->t_post_prim = 0;
+	task->t_post_next = 0;
+	__sync_synchronize();
+	task->t_posted = 0;
+
+	/*If the task was resumed or stopped by another primitive, ignore;*/
+	if ((task->t_status != SCHED_STATUS_STOPPED) || (task->t_stopper != prim))
+		return 0;
+
+	/*Resume the task;*/
+	primitive_resume_task(task);
+
+	/*Complete;*/
+	return 1;
+
+}
+
+/**
+ * sched_make_posted : makes the posted resumes of the scheduler in their
+ * posting order; if a thread is provided, the process of each task is locked
+ * with the thread's node; if not, a commit must be opened, and the resumes of
+ * tasks whose process can't be locked at once are posted again, and made
+ * when their process is unlocked;
+ * @param sched : the scheduler;
+ * @param thread : the draining thread, 0 in a commit;
+ * @return the number of resumed tasks;
+ */
+static usize sched_make_posted(struct scheduler *sched, struct sthread *thread) {
+
+	struct stask *task;
+	struct stask *next;
+	struct sprocess *prc;
+	usize nb_resumed;
+
+	/*Take the posted tasks;*/
+	task = sched_take_posted(sched);
+	nb_resumed = 0;
+
+	/*For each posted task :*/
+	while (task) {
+
+		/*Fetch the next task before the post is released;*/
+		next = task->t_post_next;
+		prc = task->t_process;
+
+		/*Lock the process; in a commit, if it is held, post the resume
+		 * again;*/
+		if (thread) {
+			process_lock_thread(prc, thread);
+		} else if (!process_commit_lock(prc)) {
+			sched_push_posted(sched, task);
+			task = next;
+			continue;
 		}
 
-		/*Mark the task updated;*/
-		task->t_status |= STASK_STATUS_UPDATED;
+		/*Make the resume, and unlock the process;*/
+		nb_resumed += task_resume_posted(task);
+		if (thread) {
+			process_unlock(prc);
+		} else {
+			process_commit_unlock(prc);
+		}
 
-		/*Fetch the task's owner;*/
-		prim = task->t_stopper;
+		task = next;
 
-		/*If the task has no owner, complete;*/
-		if (!prim)
-			break;
+	}
+
+	/*Update the statistics;*/
+	if (nb_resumed)
+		__sync_fetch_and_add(&sched->s_nb_posted_resumed, nb_resumed);
+
+	/*Complete;*/
+	return nb_resumed;
+
+}
+
+/**
+ * process_make_posted : makes the posted resumes of the tasks of the process
+ * in their posting order, and posts the resumes of other tasks again; the
+ * process and the scheduler must be locked;
+ * @param sched : the scheduler of the process;
+ * @param prc : the process whose posted resumes must be made;
+ * @return the number of resumed tasks;
+ */
+static usize process_make_posted(struct scheduler *sched, struct sprocess *prc) {
+
+	struct stask *task;
+	struct stask *next;
+	usize nb_resumed;
+
+	/*Take the posted tasks;*/
+	task = sched_take_posted(sched);
+	nb_resumed = 0;
+
+	/*For each posted task :*/
+	while (task) {
+
+		/*Fetch the next task before the post is released;*/
+		next = task->t_post_next;
+
+		/*Make the resume of a task of the process, post others again;*/
+		if (task->t_process == prc) {
+			nb_resumed += task_resume_posted(task);
+		} else {
+			sched_push_posted(sched, task);
+		}
+
+		task = next;
 
 	}
+
+	/*Update the statistics;*/
+	if (nb_resumed)
+		__sync_fetch_and_add(&sched->s_nb_posted_resumed, nb_resumed);
+
+	/*Complete;*/
+	return nb_resumed;
+
+}
+
+/**
+ * sched_post_resume : posts a resume of the task, that will be made by the
+ * next drain if the task is still stopped by the primitive; takes no lock and
+ * never waits, so that it can be called from interrupt handlers and I/O
+ * completions; a task is posted at most once at a time, and must not be
+ * unregistered while its resume is posted;
+ * @param task : the registered task to resume;
+ * @param prim : the primitive the task is expected to be stopped by;
+ * @return 1 if the resume was posted, 0 if a resume was already posted;
+ */
+u8 sched_post_resume(struct stask *task, struct sprim *prim) {
+
+	struct scheduler *sched;
+
+	/*Check parameters;*/
+	ns_check(task != 0);
+	ns_check(task->t_process != 0);
+	ns_check(prim != 0);
+
+	/*Claim the post of the task; fail if a resume is already posted;*/
+	if (!__sync_bool_compare_and_swap(&task->t_posted, 0, 1))
+		return 0;
+
+	/*Record the expected primitive;*/
+	task->t_post_prim = prim;
+
+	/*Push the task in the scheduler's posted stack;*/
+	sched = task->t_process->p_sched;
+	sched_push_posted(sched, task);
+
+	/*Complete;*/
+	return 1;
+
 }
 
+/**
+ * sched_drain_posted : makes the posted resumes of the scheduler in their
+ * posting order, locking the process of each task with the thread's node;
+ * posted resumes are also made when a commit is opened, for the processes
+ * whose lock is free; must be called with no lock held, between commits;
+ * @param thread : the registered thread that drains the posted resumes;
+ * @return the number of resumed tasks;
+ */
+usize sched_drain_posted(struct sthread *thread) {
+
+	/*Check parameter;*/
+	ns_check(thread != 0);
+	ns_check(thread->t_sched != 0);
+
+	/*Make the posted resumes;*/
+	return sched_make_posted(thread->t_sched, thread);
 
+}
 
 /*----------------------------------------------------------- thread functions*/
 
@@ -164,7 +1250,9 @@ static void thread_unregister_task(struct stask *task) {
 /**
  * proc_assign_task : assigns the provided task to the provided processor;
  * If the task is already assigned to a different processor that the new one,
- * the task is unregistered from it before;
+ * the task is unregistered from it before; the task becomes the most recent
+ * of the thread's history, and the oldest task is forgotten if the history
+ * exceeds the scheduler's limit;
  * @param thread : the thread to assign the task to;
  * @param task : the task that must be assigned to the processor;
  */
@@ -212,8 +1300,29 @@ void thread_assign_task(struct sthread *thread, struct stask *task) {
 		/*Add the task in the thread's history list;*/
 		dlist_insert_single_after(&thread->t_history, &task->t_history);
 
+		/*If the history is too long, forget its oldest task;*/
+		if ((sched->s_history_limit) &&
+			(thread->t_history_size > sched->s_history_limit)) {
+			thread_unregister_task(
+				container_of(thread->t_history.prev, struct stask, t_history)
+			);
+		}
+
+	} else if (thread->t_history.next != &task->t_history) {
+
+		/*Move the task at the head of the history;*/
+		dlist_remove(&task->t_history);
+		dlist_insert_single_after(&thread->t_history, &task->t_history);
+
 	}
 
+	/*If the thread switches task, report the switch;*/
+	if (thread->t_task != task)
+		thread->t_nb_switches++;
+
+	/*Stamp the task with the thread's switch count;*/
+	task->t_thread_stamp = thread->t_nb_switches;
+
 	/*Set the task as the active one;*/
 	thread->t_task = task;
 
@@ -224,6 +1333,31 @@ void thread_assign_task(struct sthread *thread, struct stask *task) {
 
 
 
+/*------------------------------------------------------------- task functions*/
+
+/**
+ * task_set_priority : updates the base priority of the task, and marks it
+ * updated; its effective priority, and the ones of the tasks it overrides, are
+ * recomputed at the next commit close, or when the process is unlocked if
+ * that commit could not lock it;
+ * @param task : the registered task to update;
+ * @param priority : the new base priority;
+ */
+void task_set_priority(struct stask *task, usize priority) {
+
+	/*Debug checks;*/
+	ns_check(task != 0);
+	ns_check(task->t_process != 0);
+
+	/*Update the base priority;*/
+	task->t_priority = priority;
+
+	/*Propagate the task update;*/
+	task_propagate_update(task);
+
+}
+
+
 /*-------------------------------------------------------- primitive functions*/
 
 
@@ -312,8 +1446,9 @@ static void _prim_un_override(
 	/*Reset the owner ref;*/
 	prim->p_overridden = 0;
 
-	/*Remove the primitive from the task's overriders list;*/
-	dlist_remove(&prim->p_siblings);
+	/*Remove the primitive from the task's overriders list and heap;*/
+	dlist_remove(&prim->p_overriders);
+	heap_remove(task, prim);
 
 	/*Update the number of overrider primitives;*/
 	task->t_nb_overrides--;
@@ -331,10 +1466,10 @@ static void _prim_un_override(
  * primitive_override_task : mark the task overridden by the primitive;
  * The primitive is inserted in the list of the task's overriding primitives;
  * If the primitive already has an owner, its ownership is released before;
- * If the task is not active, the function returns 1;
+ * The task must be registered; it may be stopped by another primitive, as
+ * overrides can be set up lazily, once the primitive is contended;
  * @param prim : the primitive that the task must take the ownership of;
  * @param task : the task that must take the ownership of the primitive;
- * @return 1 if the task is not active, 0 else;
  */
 void primitive_override_task(struct sprim *prim, struct stask *task) {
 
@@ -346,7 +1481,7 @@ void primitive_override_task(struct sprim *prim, struct stask *task) {
 	ns_check(task->t_process != 0);
 	ns_check(prim->p_process == task->t_process);
 	ns_check(task->t_process->p_sched != 0);
-	ns_check(task->t_status == SCHED_STATUS_ACTIVE);
+	ns_check(task->t_status != SCHED_STATUS_UNREGISTERED);
 
 	/*Fetch the scheduler of the primitive;*/
 	sched = prim->p_process->p_sched;
@@ -358,7 +1493,8 @@ void primitive_override_task(struct sprim *prim, struct stask *task) {
 	prim->p_overridden = task;
 
 	/*Insert the primitive in the task's overrider list;*/
-	dlist_insert_single_after(&task->t_overriders, &prim->p_siblings);
+	dlist_insert_single_after(&task->t_overriders, &prim->p_overriders);
+	heap_insert(task, prim);
 
 	/*Update the number of overrider primitives;*/
 	task->t_nb_overrides++;
@@ -388,6 +1524,25 @@ void primitive_unoverride_task(struct sprim *prim) {
 }
 
 
+/**
+ * task_activate : inserts the task, removed from its stopped list, in the
+ * active list, and notifies the implementation; the scheduler must be locked;
+ * @param sched : the scheduler of the task;
+ * @param task : the task to activate;
+ */
+static void task_activate(struct scheduler *sched, struct stask *task) {
+
+	/*Insert the task in the active list;*/
+	dlist_insert_single_after(&sched->s_actives, &task->t_sched_list);
+
+	/*Update the state of the task;*/
+	task->t_status = SCHED_STATUS_ACTIVE;
+
+	/*Call the scheduler implementation hook;*/
+	(*(sched->s_ops->s_resumed))(sched, task);
+
+}
+
 /**
  * primitive_activate_task : removes the task from its eventual scheduler
  * list, un-stops the task relatively to its stopping primitive if any, inserts
@@ -415,33 +1570,121 @@ void primitive_resume_task(struct stask *task) {
 	ns_check(prim->p_process == task->t_process);
 	ns_check(task->t_status == SCHED_STATUS_STOPPED)
 
-	/*Insert the task in the active list;*/
-	dlist_insert_single_after(&sched->s_actives, &task->t_sched_list);
-
 	/*Un-reference the primitive;*/
 	task->t_stopper = 0;
 
 	/*Remove the task of the primitive's stopped list;*/
 	dlist_remove(&task->t_stopped);
 
-	/*Update the number of stopped tasks;*/
-	prim->nb_stopped_tasks--;
+	/*Update the number of stopped tasks;*/
+	prim->nb_stopped_tasks--;
+
+	/*Propagate the primitive update;*/
+	primitive_propagate_update(prim);
+
+	/*Journal the activation, or activate the task with the scheduler
+	 * locked;*/
+	if (task_journal(task, 1))
+		return;
+	process_enter_sched(task->t_process);
+	task_activate(sched, task);
+	process_leave_sched(task->t_process);
+
+}
+
+
+/**
+ * primitive_resume_n : resumes the first tasks stopped by the primitive in one
+ * pass; the resumed part of the stopped list is detached at once, the
+ * primitive is marked updated once, and the implementation is notified once
+ * if it supports it;
+ * @param prim : the primitive whose tasks must be resumed;
+ * @param nb_tasks : the maximal number of tasks to resume;
+ * @return the number of resumed tasks;
+ */
+usize primitive_resume_n(struct sprim *prim, usize nb_tasks) {
+
+	struct scheduler *sched;
+	struct stask *task;
+	struct dlist *save;
+	struct dlist *last;
+	struct dlist resumed;
+	usize nb_resumed;
+
+	/*Check parameter;*/
+	ns_check(prim != 0)
+	ns_check(prim->p_process != 0)
+
+	/*Fetch the scheduler;*/
+	sched = prim->p_process->p_sched;
+	ns_check(sched != 0)
+
+	/*If the primitive stopped no task or no task must be resumed, complete;*/
+	if ((dlist_empty(&prim->p_stopped)) || (!nb_tasks))
+		return 0;
+
+	/*Find the last task to resume;*/
+	if (nb_tasks >= prim->nb_stopped_tasks) {
+		nb_resumed = prim->nb_stopped_tasks;
+		last = prim->p_stopped.prev;
+	} else {
+		nb_resumed = nb_tasks;
+		for (last = prim->p_stopped.next; --nb_tasks;) {
+			last = last->next;
+		}
+	}
+
+	/*Detach the tasks to resume at once;*/
+	resumed.next = prim->p_stopped.next;
+	resumed.prev = last;
+	prim->p_stopped.next = last->next;
+	last->next->prev = &prim->p_stopped;
+	resumed.next->prev = last->next = &resumed;
+	prim->nb_stopped_tasks -= nb_resumed;
+
+	/*Propagate the primitive update once;*/
+	primitive_propagate_update(prim);
+
+	/*Un-reference the primitive, and journal activations if possible;*/
+	dlist_head_for_each_object(task, save, &resumed, struct stask, t_stopped) {
+		ns_check(task->t_status == SCHED_STATUS_STOPPED)
+		task->t_stopper = 0;
+		if (task_journal(task, 1))
+			dlist_remove(&task->t_stopped);
+	}
+
+	/*If all activations were journaled, complete;*/
+	if (dlist_empty(&resumed))
+		return nb_resumed;
+
+	/*Lock the scheduler;*/
+	process_enter_sched(prim->p_process);
+
+	/*Activate each task;*/
+	dlist_head_for_each_object(task, save, &resumed, struct stask, t_stopped) {
+		dlist_insert_single_after(&sched->s_actives, &task->t_sched_list);
+		task->t_status = SCHED_STATUS_ACTIVE;
+	}
 
-	/*Propagate the primitive update;*/
-	primitive_propagate_update(prim);
+	/*Notify the implementation;*/
+	sched_report_resumed(sched, &resumed);
 
-	/*Update the state of the task;*/
-	task->t_status = SCHED_STATUS_ACTIVE;
+	/*Unlock the scheduler;*/
+	process_leave_sched(prim->p_process);
 
-	/*Call the scheduler implementation hook;*/
-	(*(sched->s_ops->s_resumed))(sched, task);
+	/*Complete;*/
+	return nb_resumed;
 
 }
 
 
-void primitive_stop_task(struct sprim *prim, struct stask *task) {
-
-	struct scheduler *sched;
+/**
+ * task_stop : inserts the active task in the primitive's stopped list, without
+ * deactivating it; the process must be locked;
+ * @param prim : the primitive that will stop the task;
+ * @param task : the task that must be stopped by the primitive;
+ */
+static void task_stop(struct sprim *prim, struct stask *task) {
 
 	/*Debug checks;*/
 	ns_check(task != 0)
@@ -452,14 +1695,11 @@ void primitive_stop_task(struct sprim *prim, struct stask *task) {
 	ns_check(task_active(task) != 0);
 	ns_check(task->t_stopper == 0);
 
-	/*Fetch the scheduler;*/
-	sched = task->t_process->p_sched;
-
 	/*Reference the primitive;*/
 	task->t_stopper = prim;
 
-	/*Insert the task at the end of the primitive's stopped list;*/
-	dlist_insert_single_before(&prim->p_stopped, &task->t_stopped);
+	/*Insert the task in the primitive's stopped list;*/
+	primitive_insert_stopped(prim, task);
 
 	/*Update the number of stopped tasks;*/
 	prim->nb_stopped_tasks++;
@@ -467,6 +1707,16 @@ void primitive_stop_task(struct sprim *prim, struct stask *task) {
 	/*Propagate the primitive update;*/
 	primitive_propagate_update(prim);
 
+}
+
+/**
+ * task_deactivate : removes the stopped task from the active list and notifies
+ * the implementation; the scheduler must be locked;
+ * @param sched : the scheduler of the task;
+ * @param task : the task to deactivate;
+ */
+static void task_deactivate(struct scheduler *sched, struct stask *task) {
+
 	/*Remove the task from the active list;*/
 	dlist_remove(&task->t_sched_list);
 
@@ -478,6 +1728,23 @@ void primitive_stop_task(struct sprim *prim, struct stask *task) {
 
 }
 
+void primitive_stop_task(struct sprim *prim, struct stask *task) {
+
+	/*Insert the task in the primitive's stopped list;*/
+	task_stop(prim, task);
+
+	/*If the task is journaled, journal the deactivation; other tasks may be
+	 * queued by the implementation, and are deactivated at once;*/
+	if ((task->t_flags & STASK_STATUS_JOURNALED) && (task_journal(task, 0)))
+		return;
+
+	/*Deactivate the task with the scheduler locked;*/
+	process_enter_sched(task->t_process);
+	task_deactivate(task->t_process->p_sched, task);
+	process_leave_sched(task->t_process);
+
+}
+
 
 /**
  * primitive_stop_thread : stops the task being executed by the thread, and
@@ -502,15 +1769,205 @@ void primitive_stop_thread(struct sprim *prim, struct sthread *thread) {
 	sched = thread->t_sched;
 	task = thread->t_task;
 
-	/*Stop the task;*/
-	primitive_stop_task(prim, task);
+	/*Insert the task in the primitive's stopped list;*/
+	task_stop(prim, task);
 
-	/*Assign a new task to the thread;*/
+	/*An executed task is not queued, and can't have been journaled;*/
+	ns_check(!(task->t_flags & STASK_STATUS_JOURNALED));
+
+	/*Deactivate the executed task and assign a new task to the thread, with
+	 * the scheduler locked; the deactivation is never journaled, as the
+	 * implementation would not requeue the task if it was resumed before
+	 * the merge;*/
+	process_enter_sched(prim->p_process);
+	task_deactivate(sched, task);
 	(*(sched->s_ops->s_assign_one))(sched, thread);
+	process_leave_sched(prim->p_process);
+
+}
+
+
+/**
+ * primitive_transfer_task : moves the stopped task to the stopped list of the
+ * primitive, without resuming it; both primitives are marked updated;
+ * Aborts if the task is not stopped;
+ * @param prim : the primitive that must stop the task;
+ * @param task : the stopped task to transfer;
+ */
+void primitive_transfer_task(struct sprim *prim, struct stask *task) {
+
+	struct sprim *stopper;
+
+	/*Debug checks;*/
+	ns_check(task != 0)
+	ns_check(prim != 0)
+	ns_check(task->t_process != 0);
+	ns_check(prim->p_process == task->t_process);
+	ns_check(task->t_status == SCHED_STATUS_STOPPED)
+
+	/*Fetch the current stopper;*/
+	stopper = task->t_stopper;
+	ns_check(stopper != 0);
+
+	/*Remove the task from the stopper's list;*/
+	dlist_remove(&task->t_stopped);
+	stopper->nb_stopped_tasks--;
+
+	/*Propagate the stopper update;*/
+	primitive_propagate_update(stopper);
+
+	/*Reference the new primitive and insert the task in its stopped list;*/
+	task->t_stopper = prim;
+	primitive_insert_stopped(prim, task);
+	prim->nb_stopped_tasks++;
+
+	/*Propagate the primitive update;*/
+	primitive_propagate_update(prim);
+
+}
+
+/**
+ * primitive_inherit : makes the primitive inherit the priority of the source,
+ * so that the task it overrides inherits the priority of the tasks stopped by
+ * the source; several primitives can inherit the same source, which lets one
+ * primitive's stopped tasks override several tasks; sources must not form a
+ * cycle;
+ * @param prim : the primitive to update;
+ * @param source : the primitive to inherit the priority of, 0 to stop
+ * inheriting;
+ */
+void primitive_inherit(struct sprim *prim, struct sprim *source) {
+
+	/*Debug checks;*/
+	ns_check(prim != 0);
+	ns_check(prim->p_process != 0);
+	ns_check(prim != source);
+	ns_check((!source) || (source->p_process == prim->p_process));
+
+	/*Stop inheriting the current source if any;*/
+	if (prim->p_source)
+		dlist_remove(&prim->p_inherit_list);
+
+	/*Reference the new source, and insert in its inheritors list if any;*/
+	prim->p_source = source;
+	if (source)
+		dlist_insert_single_before(&source->p_inheritors, &prim->p_inherit_list);
+
+	/*Propagate the primitive update;*/
+	primitive_propagate_update(prim);
+
+}
+
+/**
+ * primitive_set_ceiling : enables the immediate ceiling mode of the primitive;
+ * tasks that take a ceiling primitive are raised to its ceiling at once, with
+ * no propagation in the tasks-primitives tree; must be called after
+ * registration, while the primitive is not taken;
+ * @param prim : the primitive to update;
+ * @param ceiling : the ceiling, at least the priority of any task that may
+ * take the primitive;
+ */
+void primitive_set_ceiling(struct sprim *prim, usize ceiling) {
+
+	/*Debug checks;*/
+	ns_check(prim != 0);
+	ns_check(prim->p_process != 0);
+	ns_check(prim->p_ceiling_owner == 0);
+
+	/*Enable the ceiling mode;*/
+	prim->p_status |= SCHED_PRIM_STATUS_CEILING;
+	prim->p_ceiling = ceiling;
+
+}
+
+/**
+ * primitive_ceiling_take : raises the task to the ceiling of the primitive,
+ * and references it as the primitive's ceiling owner; the task must be
+ * active;
+ * @param prim : the ceiling primitive taken by the task;
+ * @param task : the task that takes the primitive;
+ */
+void primitive_ceiling_take(struct sprim *prim, struct stask *task) {
+
+	/*Debug checks;*/
+	ns_check(task != 0)
+	ns_check(prim != 0)
+	ns_check(prim->p_status & SCHED_PRIM_STATUS_CEILING);
+	ns_check(prim->p_process == task->t_process);
+	ns_check(prim->p_ceiling_owner == 0);
+	ns_check(task->t_status == SCHED_STATUS_ACTIVE);
+
+	/*Reference the owner and save its ceiling;*/
+	prim->p_ceiling_owner = task;
+	prim->p_saved_ceiling = task->t_ceiling;
+
+	/*If the ceiling raises the task, update its effective priority only, as
+	 * an active task stops no primitive, with the scheduler locked;*/
+	if (prim->p_ceiling > task->t_ceiling) {
+		task->t_ceiling = prim->p_ceiling;
+		process_enter_sched(task->t_process);
+		task_update_priority(task->t_process->p_sched, task);
+		process_leave_sched(task->t_process);
+	}
+
+}
+
+/**
+ * primitive_ceiling_release : restores the ceiling the task had before it
+ * took the primitive; ceiling primitives must be released in the reverse
+ * order of their takings;
+ * @param prim : the ceiling primitive released by its ceiling owner;
+ */
+void primitive_ceiling_release(struct sprim *prim) {
+
+	struct stask *task;
+
+	/*Debug checks;*/
+	ns_check(prim != 0)
+	ns_check(prim->p_status & SCHED_PRIM_STATUS_CEILING);
+
+	/*Fetch the owner; if none, complete;*/
+	task = prim->p_ceiling_owner;
+	if (!task)
+		return;
+
+	/*Un-reference the owner;*/
+	prim->p_ceiling_owner = 0;
+
+	/*If the ceiling lowers, update the task's effective priority only, with
+	 * the scheduler locked;*/
+	if (task->t_ceiling != prim->p_saved_ceiling) {
+		task->t_ceiling = prim->p_saved_ceiling;
+		process_enter_sched(task->t_process);
+		task_update_priority(task->t_process->p_sched, task);
+		process_leave_sched(task->t_process);
+	}
 
 }
 
+/**
+ * primitive_set_ordered : selects the order of the primitive's stopped list;
+ * if ordered, stopped tasks are kept ordered by decreasing effective priority,
+ * and repositioned when their effective priority is recomputed; must be called
+ * after registration, while the primitive stopped no task;
+ * @param prim : the primitive to update;
+ * @param ordered : 1 for the priority order, 0 for the stop order;
+ */
+void primitive_set_ordered(struct sprim *prim, u8 ordered) {
+
+	/*Debug checks;*/
+	ns_check(prim != 0);
+	ns_check(prim->p_process != 0);
+	ns_check(dlist_empty(&prim->p_stopped));
+
+	/*Update the order flag;*/
+	if (ordered) {
+		prim->p_status |= SCHED_PRIM_STATUS_ORDERED;
+	} else {
+		prim->p_status &= ~SCHED_PRIM_STATUS_ORDERED;
+	}
 
+}
 
 
 /*---------------------------------------------------------- process functions*/
@@ -537,21 +1994,44 @@ void process_register_task(struct sprocess *prc, struct stask *task) {
 
 	/*Initialize the task;*/
 	task->t_status = SCHED_STATUS_ACTIVE;
-	dlist_insert_single_after(&sched->s_actives, &task->t_sched_list);
+	task->t_flags = 0;
 	task->t_commit = (usize) -1;
 	task->t_process = prc;
 	dlist_insert_single_after(&prc->p_tasks, &task->t_siblings);
 	task->t_nb_owned_primitives = 0;
 	task->t_nb_overrides = 0;
 	dlist_init(&task->t_overriders);
+	task->t_overriders_heap = 0;
+	task->t_ceiling = 0;
 	task->t_stopper = 0;
 	dlist_init(&task->t_stopped);
 	task->t_thread = 0;
 	dlist_init(&task->t_history);
+	task->t_thread_stamp = 0;
+	dlist_init(&task->t_dirty);
+	dlist_init(&task->t_run_list);
+	task->t_deque = 0;
+	dlist_init(&task->t_journal);
+	task->t_posted = 0;
+	task->t_post_prim = 0;
+	task->t_post_next = 0;
 
 	/*Report the task registration;*/
 	prc->p_nb_tasks++;
 
+	/*Lock the scheduler;*/
+	process_enter_sched(prc);
+
+	/*Insert the task in the active list;*/
+	dlist_insert_single_after(&sched->s_actives, &task->t_sched_list);
+
+	/*Compute its priority and call the scheduler implementation hook;*/
+	task->t_effective = (*(sched->s_ops->s_get_task_priority))(sched, task);
+	(*(sched->s_ops->s_registered))(sched, task);
+
+	/*Unlock the scheduler;*/
+	process_leave_sched(prc);
+
 }
 
 /**
@@ -572,6 +2052,8 @@ err_t process_unregister_task(struct sthread *thread) {
 	struct dlist *head;
 	struct dlist *save;
 	struct sprim *overrider;
+	struct sprim *stopper;
+	u8 listed;
 
 	/*Check parameter;*/
 	ns_check(thread != 0);
@@ -586,19 +2068,21 @@ err_t process_unregister_task(struct sthread *thread) {
 	ns_check(task_active(task) != 0);
 	ns_check(task->t_process);
 	ns_check(task->t_process->p_sched == sched);
+	ns_check(task->t_posted == 0);
 
 
-	/*If the task is stopped :*/
-	if (task->t_status == SCHED_STATUS_STOPPED) {
-
-		/*Resume the task;*/
-		primitive_resume_task(task);
+	/*Fetch the task's process;*/
+	prc = task->t_process;
 
+	/*If the task is stopped, remove it from its stopper's list;*/
+	stopper = task->t_stopper;
+	if (stopper) {
+		task->t_stopper = 0;
+		dlist_remove(&task->t_stopped);
+		stopper->nb_stopped_tasks--;
+		primitive_propagate_update(stopper);
 	}
 
-	/*Remove the task from the active list if present;*/
-	dlist_remove(&task->t_sched_list);
-
 	/*Fetch the head of the overriding list;*/
 	head = &task->t_overriders;
 
@@ -612,17 +2096,27 @@ err_t process_unregister_task(struct sthread *thread) {
 
 	}
 
-	/*Unregister the task from its thread;*/
-	thread_unregister_task(task);
+	/*Forget the task's update mark;*/
+	dlist_remove(&task->t_dirty);
+	task->t_flags &= ~STASK_STATUS_UPDATED;
 
-	/*Fetch the task's process;*/
-	prc = task->t_process;
+	/*Report the removal;*/
+	prc->p_nb_tasks--;
 
-	/*Remove the task from its processor list if present;*/
+	/*Lock the scheduler;*/
+	process_enter_sched(prc);
+
+	/*Forget the task's journal entry, and resume it if it is not listed;*/
+	listed = task_listed(task);
+	task_unjournal(task);
+	if (!listed)
+		task_activate(sched, task);
+
+	/*Remove the task from the active list;*/
 	dlist_remove(&task->t_sched_list);
 
-	/*Report the removal;*/
-	prc->p_nb_tasks--;
+	/*Unregister the task from its thread;*/
+	thread_unregister_task(task);
 
 	/*Call the scheduler implementation hook;*/
 	(*(sched->s_ops->s_unregistered))(sched, task);
@@ -630,6 +2124,9 @@ err_t process_unregister_task(struct sthread *thread) {
 	/*Assign a new task to the thread;*/
 	(*(sched->s_ops->s_assign_one))(sched, thread);
 
+	/*Unlock the scheduler;*/
+	process_leave_sched(prc);
+
 	/*Return 1 if the task still has owned primitives;*/
 	return task->t_nb_owned_primitives ? (u8) 1 : (u8) 0;
 }
@@ -656,6 +2153,15 @@ void process_register_prim(struct sprocess *prc, struct sprim *prim) {
 	dlist_init(&prim->p_stopped);
 	prim->p_overridden = 0;
 	dlist_init(&prim->p_overriders);
+	prim->p_heap_child = prim->p_heap_next = prim->p_heap_prev = 0;
+	prim->p_priority = 0;
+	prim->p_source = 0;
+	dlist_init(&prim->p_inheritors);
+	dlist_init(&prim->p_inherit_list);
+	dlist_init(&prim->p_dirty);
+	prim->p_ceiling = 0;
+	prim->p_ceiling_owner = 0;
+	prim->p_saved_ceiling = 0;
 
 	/*Report the registration;*/
 	prc->p_nb_primitives = 0;
@@ -676,6 +2182,7 @@ err_t process_unregister_prim(struct sprim *prim) {
 	struct dlist *head;
 	struct dlist *save;
 	struct stask *task;
+	struct sprim *inheritor;
 
 	/*Arg check;*/
 	ns_check(prim);
@@ -705,9 +2212,24 @@ err_t process_unregister_prim(struct sprim *prim) {
 
 	}
 
+	/*Stop inheriting our source if any;*/
+	if (prim->p_source)
+		primitive_inherit(prim, 0);
+
+	/*Make our inheritors stop inheriting us;*/
+	head = &prim->p_inheritors;
+	dlist_head_for_each_object(inheritor, save, head, struct sprim,
+		p_inherit_list) {
+		primitive_inherit(inheritor, 0);
+	}
+
 	/*Remove the primitive from its process list;*/
 	dlist_remove_unsafe(&prim->p_siblings);
 
+	/*Forget the primitive's update mark;*/
+	dlist_remove(&prim->p_dirty);
+	prim->p_status &= ~SCHED_PRIM_STATUS_UPDATED;
+
 	/*Report the un-registration;*/
 	prc->p_nb_primitives--;
 	
@@ -730,6 +2252,40 @@ static __inline__ void abort_if_commit_closed(struct scheduler *sched) {
 }
 
 
+/**
+ * sched_ctor : resets all fields and lists of the scheduler, and its lock,
+ * except its operations, that must be initialized by the caller;
+ * @param sched : the scheduler to construct;
+ */
+void sched_ctor(struct scheduler *sched) {
+
+	/*Check parameter;*/
+	ns_check(sched != 0);
+
+	/*Initialize the scheduler;*/
+	sched->s_commit_opened = 0;
+	sched->s_commit_index = 0;
+	dlist_init(&sched->s_actives);
+	dlist_init(&sched->s_processes);
+	sched->s_nb_processes = 0;
+	dlist_init(&sched->s_threads);
+	sched->s_nb_threads = 0;
+	sched->s_history_limit = 0;
+	sched->s_nb_priority_updates = 0;
+
+	/*Initialize the lock;*/
+	lock_init(&sched->s_lock);
+
+	/*Disable the journal mode;*/
+	sched->s_journaled = 0;
+	sched->s_nb_journaled = 0;
+
+	/*Initialize the posted stack;*/
+	sched->s_posted = 0;
+	sched->s_nb_posted_resumed = 0;
+
+}
+
 /**
  * sched_register_thread : registers the thread in the scheduler;
  * @param sched : the scheduler to update;
@@ -748,6 +2304,9 @@ void sched_register_thread(struct scheduler *sched, struct sthread *thread) {
 	thread->t_task = 0;
 	dlist_init(&thread->t_history);
 	thread->t_history_size = 0;
+	thread->t_nb_switches = 0;
+	lock_node_init(&thread->t_lock_node);
+	lock_node_init(&thread->t_process_node);
 
 	/*Report the registration;*/
 	sched->s_nb_threads++;
@@ -773,6 +2332,14 @@ void sched_register_process(struct scheduler *sched, struct sprocess *prc) {
 	prc->p_nb_tasks = 0;
 	dlist_init(&prc->p_primitives);
 	prc->p_nb_primitives = 0;
+	lock_init(&prc->p_lock);
+	lock_node_init(&prc->p_sched_node);
+	prc->p_sched_held = 0;
+	prc->p_deferred = 0;
+	dlist_init(&prc->p_dirty_tasks);
+	dlist_init(&prc->p_dirty_prims);
+	prc->p_journaling = 0;
+	dlist_init(&prc->p_journal);
 
 	/*Initialize and register the process primitive;*/
 	process_register_prim(prc, &prc->p_prim);
@@ -842,6 +2409,8 @@ void sched_unregister_process(struct sprocess *prc) {
 	struct dlist *head;
 	struct dlist *save;
 	struct stask *task;
+	struct sprim *prim;
+	u8 listed;
 
 	/*Check arg;*/
 	ns_check(prc != 0);
@@ -855,22 +2424,47 @@ void sched_unregister_process(struct sprocess *prc) {
 	/*Abort if no commit is opened;*/
 	abort_if_commit_closed(sched);
 
+	/*Check that the process is locked;*/
+	ns_check(prc->p_lock.l_tail != 0);
+
 	/*Fetch the ref of the task list;*/
 	head = &prc->p_tasks;
 
 	/*For each registered task :*/
 	dlist_head_for_each_object(task, save, head, struct stask, t_siblings) {
 
-		/*If the task is active :*/
-		if (task->t_status == SCHED_STATUS_ACTIVE) {
+		/*Forget the task's journal entry if any;*/
+		listed = task_listed(task);
+		task_unjournal(task);
+
+		/*If the task is in the active list :*/
+		if (listed) {
 
 			/*Remove the task from the scheduler list;*/
 			dlist_remove_unsafe(&task->t_sched_list);
 
+			/*Call the scheduler implementation hook;*/
+			(*(sched->s_ops->s_unregistered))(sched, task);
+
 		}
 
 	}
 
+	/*Forget the update marks of the process's tasks and primitives;*/
+	while (!dlist_empty(&prc->p_dirty_tasks)) {
+		task = container_of(prc->p_dirty_tasks.next, struct stask, t_dirty);
+		dlist_remove(&task->t_dirty);
+		task->t_flags &= ~STASK_STATUS_UPDATED;
+	}
+	while (!dlist_empty(&prc->p_dirty_prims)) {
+		prim = container_of(prc->p_dirty_prims.next, struct sprim, p_dirty);
+		dlist_remove(&prim->p_dirty);
+		prim->p_status &= ~SCHED_PRIM_STATUS_UPDATED;
+	}
+
+	/*Forget the work deferred by commits;*/
+	prc->p_deferred = 0;
+
 	/*Remove the process from the scheduler list;*/
 	dlist_remove_unsafe(&prc->p_list);
 
@@ -908,6 +2502,9 @@ void sched_pause_process(struct sprocess *prc) {
 	/*Abort if no commit is opened;*/
 	abort_if_commit_closed(sched);
 
+	/*The process was locked before the scheduler;*/
+	process_hold_sched(prc, 1);
+
 	/*Fetch the ref of the task list;*/
 	head = &prc->p_tasks;
 
@@ -924,6 +2521,9 @@ void sched_pause_process(struct sprocess *prc) {
 
 	}
 
+	/*Release the scheduler to the caller;*/
+	process_hold_sched(prc, 0);
+
 	/*Mark the process stopped;*/
 	prc->p_status = SCHED_STATUS_STOPPED;
 
@@ -959,6 +2559,9 @@ void sched_resume_process(struct sprocess *prc) {
 	/*Abort if no commit is opened;*/
 	abort_if_commit_closed(sched);
 
+	/*The process was locked before the scheduler;*/
+	process_hold_sched(prc, 1);
+
 	/*Fetch the ref of the process's primitive's stopped tasks list;*/
 	head = &prc->p_prim.p_stopped;
 
@@ -970,6 +2573,9 @@ void sched_resume_process(struct sprocess *prc) {
 
 	}
 
+	/*Release the scheduler to the caller;*/
+	process_hold_sched(prc, 0);
+
 	/*Mark the process active;*/
 	prc->p_status = SCHED_STATUS_ACTIVE;
 
@@ -979,36 +2585,128 @@ void sched_resume_process(struct sprocess *prc) {
 
 /**
  * sched_lock : attempts to locks the scheduler;
- * This function must be called before any operation is made on the scheduler;
+ * This function must be called before any operation is made on the scheduler,
+ * and before a commit is opened;
  * @param sched : the scheduler to lock;
- * @return 01 if the lock succeeded, 0 if the scheduler was already locked;
+ * @return 1 if the lock succeeded, 0 if the scheduler was already locked;
  */
 u8 sched_lock(struct scheduler *sched) {
 
-	u8 locked;
-	
-	/*Attempt to lock the scheduler's spinlock;*/
-	locked = arch_spin_lock_nb(&sched->s_lock);
+	/*Attempt to lock the scheduler's lock;*/
+	return lock_try(&sched->s_lock);
+
+}
 
-	/*If we locked the scheduler :*/
-	return locked;
+/**
+ * sched_lock_wait : locks the scheduler, waiting in the lock's queue until
+ * the previous holders unlocked it;
+ * @param sched : the scheduler to lock;
+ * @param node : the caller's queue node, unused until the scheduler is
+ * unlocked;
+ */
+void sched_lock_wait(struct scheduler *sched, struct sched_lock_node *node) {
+
+	/*Check parameters;*/
+	ns_check(sched != 0);
+	ns_check(node != 0);
+
+	/*Wait for the scheduler's lock;*/
+	lock_wait(&sched->s_lock, node);
 
 }
 
 /**
  * sched_unlock : unlocks the scheduler; aborts if the scheduler is unlocked;
+ * the lock is handed off to the first waiter if any;
  * @param sched : the scheduler to unlock;
  */
 void sched_unlock(struct scheduler *sched) {
-	
+
+	/*Unlock the scheduler;*/
+	lock_release(&sched->s_lock);
+
+}
+
+/**
+ * process_lock_wait : locks the process, waiting in the lock's queue until
+ * the previous holders unlocked it; must be called with the scheduler
+ * unlocked;
+ * @param prc : the process to lock;
+ * @param node : the caller's queue node, unused until the process is unlocked;
+ */
+void process_lock_wait(struct sprocess *prc, struct sched_lock_node *node) {
+
+	/*Check parameters;*/
+	ns_check(prc != 0);
+	ns_check(node != 0);
+
+	/*Wait for the process's lock;*/
+	lock_wait(&prc->p_lock, node);
+
+}
+
+/**
+ * process_apply_deferred : applies the work of the commits that could not
+ * lock the process : makes its posted resumes, merges its journal, and
+ * recomputes the priorities of its marked objects, with the scheduler locked;
+ * @param prc : the locked process, marked deferred;
+ */
+static void process_apply_deferred(struct sprocess *prc) {
+
+	struct scheduler *sched;
+	struct dlist resumed;
+
+	/*Fetch the scheduler;*/
+	sched = prc->p_sched;
+
+	/*Lock the scheduler, and reset the mark under its lock;*/
+	process_enter_sched(prc);
+	process_hold_sched(prc, 1);
+	prc->p_deferred = 0;
+
+	/*Make the posted resumes of the process;*/
+	process_make_posted(sched, prc);
+
+	/*Merge the journal of the process, and report resumed tasks;*/
+	dlist_init(&resumed);
+	process_merge_journal(sched, prc, &resumed);
+	sched_report_resumed(sched, &resumed);
+
+	/*Recompute priorities of updated tasks and primitives;*/
+	process_update_priorities(sched, prc);
+
 	/*Unlock the scheduler;*/
-	arch_spin_unlock(&sched->s_lock);
+	process_hold_sched(prc, 0);
+	process_leave_sched(prc);
+
+}
+
+/**
+ * process_unlock : unlocks the process; if a commit could not lock the
+ * process, its posted resumes, journal and priority marks are applied first,
+ * with the scheduler locked; the lock is handed off to the first waiter if
+ * any; must be called with the scheduler unlocked;
+ * @param prc : the process to unlock;
+ */
+void process_unlock(struct sprocess *prc) {
+
+	/*Stop journaling;*/
+	prc->p_journaling = 0;
+
+	/*Apply the work of the commits that could not lock the process;*/
+	if (prc->p_deferred)
+		process_apply_deferred(prc);
+
+	/*Unlock the process;*/
+	lock_release(&prc->p_lock);
 
 }
 
 /**
- * sched_open_commit : opens a new commit for the provided scheduler;
- * commit functions will be authorised after;
+ * sched_open_commit : opens a new commit for the provided scheduler, and
+ * makes the posted resumes of the processes whose lock is free; others are
+ * posted again, and made when their process is unlocked; commit functions
+ * will be authorised after;
  * Aborts if a commit is already opened;
  * @param sched : the scheduler to open a commit in;
  */
@@ -1023,6 +2721,9 @@ void sched_open_commit(struct scheduler *sched) {
 	/*Update the commit index;*/
 	sched->s_commit_index++;
 
+	/*Make the posted resumes of the processes that can be locked;*/
+	sched_make_posted(sched, 0);
+
 }
 
 /**
@@ -1039,6 +2740,12 @@ void sched_close_commit(struct scheduler *sched) {
 	/*Mark the commit opened;*/
 	sched->s_commit_opened = 0;
 
+	/*Apply the activity changes journaled in processes;*/
+	sched_merge_journals(sched);
+
+	/*Recompute priorities of updated tasks and primitives;*/
+	sched_update_priorities(sched);
+
 	/*Reschedule tasks;*/
 	(*(sched->s_ops->s_schedule))(sched);
 
@@ -1047,3 +2754,59 @@ void sched_close_commit(struct scheduler *sched) {
 
 }
 
+/**
+ * sched_set_journaled : enables or disables the journal mode; in journal
+ * mode, the activity changes made by a thread that locked the process with
+ * process_lock_thread are recorded in the process's journal, without the
+ * scheduler lock; at commit close, the journal of each process whose lock is
+ * free is merged in one pass, where the active list and the implementation
+ * are updated; resumed tasks are thus not scheduled before a commit close;
+ * the task executed by a thread is never journaled : when it is stopped, the
+ * thread locks the scheduler to deactivate it and to be assigned a new task;
+ * @param sched : the scheduler to update;
+ * @param journaled : 1 to enable the journal mode, 0 to disable it;
+ */
+void sched_set_journaled(struct scheduler *sched, u8 journaled) {
+
+	/*Check parameter;*/
+	ns_check(sched != 0);
+
+	/*Update the mode; pending journals are merged at the next commit close;*/
+	sched->s_journaled = (u8) (journaled != 0);
+
+}
+
+/**
+ * sched_set_history_limit : updates the maximal number of tasks in a thread's
+ * history; longer histories forget their oldest tasks at once; the scheduler
+ * must be locked;
+ * @param sched : the scheduler to update;
+ * @param limit : the new limit, 0 for unbounded histories;
+ */
+void sched_set_history_limit(struct scheduler *sched, usize limit) {
+
+	struct sthread *thread;
+	struct dlist *save;
+
+	/*Check parameter;*/
+	ns_check(sched != 0);
+
+	/*Update the limit;*/
+	sched->s_history_limit = limit;
+
+	/*If histories are unbounded, complete;*/
+	if (!limit)
+		return;
+
+	/*Forget the oldest tasks of each history until it fits the limit;*/
+	dlist_head_for_each_object(thread, save, &sched->s_threads,
+		struct sthread, t_list) {
+		while (thread->t_history_size > limit) {
+			thread_unregister_task(
+				container_of(thread->t_history.prev, struct stask, t_history)
+			);
+		}
+	}
+
+}
+
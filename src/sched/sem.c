@@ -22,10 +22,82 @@ void sched_sem_ctor(
 
 	/*Initialize and register the semaphore;*/
 	sem->s_nb_owners = nb_takings;
+	sem->s_slots = 0;
 	process_register_prim(prc, &sem->s_prim);
 
 }
 
+/**
+ * sched_sem_inherit : enables priority inheritance; each taking is
+ * associated with a holder slot, a primitive that overrides the holder and
+ * inherits the priority of the semaphore, so that stopped tasks override all
+ * holders; must be called after construction, before any taking;
+ * @param sem : the semaphore to update;
+ * @param slots : the holder slots, as many as the maximal number of takings;
+ */
+void sched_sem_inherit(struct sched_sem *sem, struct sprim *slots) {
+
+	usize id;
+
+	/*Args check;*/
+	ns_check(sem);
+	ns_check(slots);
+	ns_check(!sem->s_prim.p_nb_owning_tasks);
+
+	/*Register the slots, and make them inherit the semaphore's priority;*/
+	for (id = 0; id < sem->s_nb_owners; id++) {
+		process_register_prim(sem->s_prim.p_process, slots + id);
+		primitive_inherit(slots + id, &sem->s_prim);
+	}
+
+	/*Enable inheritance;*/
+	sem->s_slots = slots;
+
+}
+
+/**
+ * sem_task_slot : finds a holder slot that overrides the task;
+ * @param sem : the semaphore to search in;
+ * @param task : the task to search the slot of, 0 for a free slot;
+ * @return the slot of @task, 0 if none;
+ */
+static struct sprim *sem_task_slot(struct sched_sem *sem, struct stask *task) {
+
+	usize id;
+
+	/*Find a slot overriding the task;*/
+	for (id = 0; id < sem->s_nb_owners; id++) {
+		if (sem->s_slots[id].p_overridden == task)
+			return sem->s_slots + id;
+	}
+
+	/*No slot overrides the task;*/
+	return 0;
+
+}
+
+/**
+ * sem_take : makes the task take the ownership of the semaphore once, and if
+ * inheritance is enabled, makes a free holder slot override it;
+ * @param sem : the semaphore to take, must be available;
+ * @param task : the task that must take the semaphore;
+ */
+static void sem_take(struct sched_sem *sem, struct stask *task) {
+
+	struct sprim *slot;
+
+	/*Make the task take the ownership of the semaphore;*/
+	primitive_take_ownership(&sem->s_prim, task);
+
+	/*If inheritance is enabled, make a free slot override the task;*/
+	if (sem->s_slots) {
+		slot = sem_task_slot(sem, 0);
+		ns_check(slot);
+		primitive_override_task(slot, task);
+	}
+
+}
+
 /**
  * sched_sem_take : if the semaphore's ownership can be taken once, it is taken
  * by the task executed by the provided thread; if not, the executed task is
@@ -49,7 +121,7 @@ void sched_sem_take(struct sched_sem *sem, struct sthread *thread) {
 		/*If the semaphore can be taken :*/
 
 		/*Make the task take the ownership of the semaphore;*/
-		primitive_take_ownership(&sem->s_prim, thread->t_task);
+		sem_take(sem, thread->t_task);
 
 	}
 
@@ -78,7 +150,7 @@ u8 sched_sem_take_nb(struct sched_sem *sem, struct sthread *thread) {
 	/*If the semaphore can be taken :*/
 
 	/*Make the task take the ownership of the semaphore;*/
-	primitive_take_ownership(&sem->s_prim, thread->t_task);
+	sem_take(sem, thread->t_task);
 
 	/*Complete;*/
 	return 1;
@@ -96,6 +168,8 @@ u8 sched_sem_take_nb(struct sched_sem *sem, struct sthread *thread) {
  */
 err_t sched_sem_release(struct sched_sem *sem, struct sthread *thread) {
 
+	struct stask *task;
+	struct sprim *slot;
 	err_t error;
 
 	/*Args check;*/
@@ -110,17 +184,131 @@ err_t sched_sem_release(struct sched_sem *sem, struct sthread *thread) {
 		return 1;
 	}
 
-	/*If the primitive has a stopped task :*/
-	if (!dlist_empty(&sem->s_prim.p_stopped)) {
+	/*If inheritance is enabled, release one slot overriding the task;*/
+	if (sem->s_slots) {
+		slot = sem_task_slot(sem, thread->t_task);
+		if (slot)
+			primitive_unoverride_task(slot);
+	}
 
-		/*Resume the first task;*/
-		primitive_resume_task(
-				container_of(&sem->s_prim.p_stopped, struct stask, t_stopped)
-		);
+	/*Fetch the first stopped task;*/
+	task = primitive_first_stopped(&sem->s_prim);
 
+	/*If the primitive has a stopped task, resume it;*/
+	if (task) {
+		primitive_resume_task(task);
 	}
 	
 	/*Complete;*/
 	return 0;
 
 }
+
+/**
+ * sched_sem_take_n : if the semaphore's ownership can be taken the provided
+ * number of times, it is taken by the task executed by the provided thread;
+ * if not, the executed task is stopped and a new one is assigned to the
+ * thread;
+ * @param sem : the semaphore to take;
+ * @param nb_takings : the number of takings, at most the semaphore's limit;
+ * @param thread : the thread executing the task that must take;
+ */
+void sched_sem_take_n(
+		struct sched_sem *sem,
+		usize nb_takings,
+		struct sthread *thread
+) {
+
+	/*Args check;*/
+	ns_check(sem);
+	ns_check(thread);
+	ns_check(nb_takings <= sem->s_nb_owners);
+
+	/*If the semaphore can't be taken enough times, stop the thread's task;*/
+	if (!sched_sem_take_n_nb(sem, nb_takings, thread))
+		primitive_stop_thread(&sem->s_prim, thread);
+
+}
+
+/**
+ * sched_sem_take_n_nb : non blocking multiple take function;
+ * @param sem : the semaphore to take;
+ * @param nb_takings : the number of takings;
+ * @param thread : the thread executing the task that must take;
+ * @return 1 if the takings succeed, 0 if not;
+ */
+u8 sched_sem_take_n_nb(
+		struct sched_sem *sem,
+		usize nb_takings,
+		struct sthread *thread
+) {
+
+	/*Args check;*/
+	ns_check(sem);
+	ns_check(thread);
+
+	/*If the semaphore can't be taken enough times, fail;*/
+	if (sem->s_nb_owners - sem->s_prim.p_nb_owning_tasks < nb_takings)
+		return 0;
+
+	/*Take the semaphore the required number of times;*/
+	for (; nb_takings; nb_takings--) {
+		sem_take(sem, thread->t_task);
+	}
+
+	/*Complete;*/
+	return 1;
+
+}
+
+/**
+ * sched_sem_release_n : releases the provided number of ownerships of the
+ * semaphore, and resumes, in one pass, as many stopped tasks as the semaphore
+ * can now be taken times;
+ * @param sem : the semaphore to release;
+ * @param nb_takings : the number of ownerships to release;
+ * @param thread : the thread executing the task that should release its
+ * ownerships of the semaphore;
+ * @return 0 if the ownerships were successfully released, 1 if an ownership
+ * release error occurred;
+ */
+err_t sched_sem_release_n(
+		struct sched_sem *sem,
+		usize nb_takings,
+		struct sthread *thread
+) {
+
+	struct stask *task;
+	struct sprim *slot;
+
+	/*Args check;*/
+	ns_check(sem);
+	ns_check(thread);
+
+	/*Fetch the thread's task;*/
+	task = thread->t_task;
+
+	/*Release each ownership;*/
+	for (; nb_takings; nb_takings--) {
+
+		/*Release the ownership of the primitive; if an error occurred, fail;*/
+		if (primitive_release_ownership(&sem->s_prim, task))
+			return 1;
+
+		/*If inheritance is enabled, release one slot overriding the task;*/
+		if (sem->s_slots) {
+			slot = sem_task_slot(sem, task);
+			if (slot)
+				primitive_unoverride_task(slot);
+		}
+
+	}
+
+	/*Resume as many stopped tasks as available takings, in one pass;*/
+	primitive_resume_n(&sem->s_prim,
+		sem->s_nb_owners - sem->s_prim.p_nb_owning_tasks);
+
+	/*Complete;*/
+	return 0;
+
+}
@@ -0,0 +1,512 @@
+/*steal.c - kerneltk - GPLV3, copyleft 2019 Raphael Outhier;*/
+
+#include <sched/steal.h>
+
+#include <check.h>
+
+
+/*-------------------------------------------------------------------- deques*/
+
+/**
+ * deque_insert : inserts the task in the deque, after the provided node, and
+ * makes the deque its queue;
+ * @param deque : the deque to update;
+ * @param node : the node to insert the task after;
+ * @param task : the task to insert;
+ */
+static __inline__ void deque_insert(
+		struct sched_deque *deque,
+		struct dlist *node,
+		struct stask *task
+) {
+
+	dlist_insert_single_after(node, &task->t_run_list);
+	task->t_deque = deque;
+	deque->d_nb_tasks++;
+
+}
+
+/**
+ * deque_remove : removes the task from its deque;
+ * @param task : the queued task to remove;
+ */
+static __inline__ void deque_remove(struct stask *task) {
+
+	dlist_remove(&task->t_run_list);
+	task->t_deque->d_nb_tasks--;
+	task->t_deque = 0;
+
+}
+
+/**
+ * deque_push_top : pushes a task at the top of the deque;
+ * @param deque : the deque to update;
+ * @param task : the task to push;
+ */
+static __inline__ void deque_push_top(
+		struct sched_deque *deque,
+		struct stask *task
+) {
+
+	deque_insert(deque, &deque->d_tasks, task);
+
+}
+
+/**
+ * sched_deque_init : initializes an empty deque;
+ * @param deque : the deque to initialize;
+ */
+void sched_deque_init(struct sched_deque *deque) {
+
+	dlist_init(&deque->d_tasks);
+	deque->d_nb_tasks = 0;
+
+}
+
+/**
+ * sched_deque_push : pushes a task at the bottom of the deque;
+ * @param deque : the deque to update;
+ * @param task : the task to push, queued nowhere;
+ */
+void sched_deque_push(struct sched_deque *deque, struct stask *task) {
+
+	deque_insert(deque, deque->d_tasks.prev, task);
+
+}
+
+/**
+ * sched_deque_pop : removes the task at the bottom of the deque;
+ * @param deque : the deque to update;
+ * @return the removed task, 0 if the deque is empty;
+ */
+struct stask *sched_deque_pop(struct sched_deque *deque) {
+
+	struct stask *task;
+
+	/*If the deque is empty, complete;*/
+	if (dlist_empty(&deque->d_tasks))
+		return 0;
+
+	/*Remove the bottom task;*/
+	task = container_of(deque->d_tasks.prev, struct stask, t_run_list);
+	deque_remove(task);
+
+	/*Complete;*/
+	return task;
+
+}
+
+/**
+ * sched_deque_steal : removes the task at the top of the deque;
+ * @param deque : the deque to update;
+ * @return the removed task, 0 if the deque is empty;
+ */
+struct stask *sched_deque_steal(struct sched_deque *deque) {
+
+	struct stask *task;
+
+	/*If the deque is empty, complete;*/
+	if (dlist_empty(&deque->d_tasks))
+		return 0;
+
+	/*Remove the top task;*/
+	task = container_of(deque->d_tasks.next, struct stask, t_run_list);
+	deque_remove(task);
+
+	/*Complete;*/
+	return task;
+
+}
+
+/*------------------------------------------------------------------ internals*/
+
+/**
+ * steal_policy : determines the policy whose operations are installed in the
+ * scheduler;
+ * @param sched : the scheduler;
+ * @return the policy of @sched;
+ */
+static __inline__ struct sched_steal *steal_policy(struct scheduler *sched) {
+
+	return container_of(sched->s_ops, struct sched_steal, s_ops);
+
+}
+
+/**
+ * steal_thread : determines the steal thread of a scheduler thread;
+ * @param thread : the scheduler thread;
+ * @return the steal thread containing @thread;
+ */
+static __inline__ struct steal_thread *steal_thread(struct sthread *thread) {
+
+	return container_of(thread, struct steal_thread, s_thread);
+
+}
+
+/**
+ * steal_from_victims : attempts to steal a task from each other thread, in
+ * list order, starting after the thief;
+ * @param sched : the scheduler;
+ * @param thief : the thief thread;
+ * @return the stolen task, 0 if none could be stolen;
+ */
+static struct stask *steal_from_victims(
+		struct scheduler *sched,
+		struct sthread *thief
+) {
+
+	struct dlist *node;
+	struct stask *task;
+
+	/*For each other thread :*/
+	for (node = thief->t_list.next; node != &thief->t_list;
+		 node = node->next) {
+
+		/*Skip the list head;*/
+		if (node == &sched->s_threads)
+			continue;
+
+		/*Attempt to steal a task;*/
+		task = sched_deque_steal(
+			&steal_thread(container_of(node, struct sthread, t_list))->s_deque
+		);
+
+		/*If a task was stolen, complete;*/
+		if (task)
+			return task;
+
+	}
+
+	/*No task could be stolen;*/
+	return 0;
+
+}
+
+/**
+ * steal_distribute : distributes injected tasks in the deques of the threads;
+ * a task is pushed in the deque of its last thread if the deque's load is
+ * below the average, and in the next deque below the average otherwise;
+ * must only be called when threads are idle;
+ * @param sched : the scheduler;
+ * @param policy : the policy of @sched;
+ */
+static void steal_distribute(struct scheduler *sched, struct sched_steal *policy) {
+
+	struct sthread *thread;
+	struct steal_thread *target;
+	struct stask *task;
+	struct dlist *cursor;
+	struct dlist *save;
+	struct dlist *head;
+	usize average;
+	usize load;
+
+	/*If no thread is registered, tasks stay injected;*/
+	if (!sched->s_nb_threads)
+		return;
+
+	/*Determine the total load;*/
+	head = &sched->s_threads;
+	load = policy->s_nb_injected;
+	dlist_head_for_each_object(thread, save, head, struct sthread, t_list) {
+		load += steal_thread(thread)->s_deque.d_nb_tasks;
+	}
+
+	/*Determine the maximal balanced load;*/
+	average = load / sched->s_nb_threads + 1;
+	policy->s_nb_queued = load;
+
+	/*For each injected task :*/
+	cursor = head;
+	while (!dlist_empty(&policy->s_inject)) {
+
+		/*Fetch the first injected task;*/
+		task = container_of(policy->s_inject.next, struct stask, t_run_list);
+
+		/*Prefer the task's last thread if it is not overloaded;*/
+		target = (task->t_thread) ? steal_thread(task->t_thread) : 0;
+		if ((!target) || (target->s_deque.d_nb_tasks >= average)) {
+
+			/*Find the next thread below the average; one exists, as the
+			 * average is above the mean load;*/
+			do {
+				cursor = cursor->next;
+				if (cursor == head)
+					cursor = cursor->next;
+				target = steal_thread(
+					container_of(cursor, struct sthread, t_list)
+				);
+			} while (target->s_deque.d_nb_tasks >= average);
+
+		}
+
+		/*Move the task from the injection list to the deque;*/
+		dlist_remove(&task->t_run_list);
+		policy->s_nb_injected--;
+		sched_deque_push(&target->s_deque, task);
+
+	}
+
+}
+
+/*---------------------------------------------------------- state transitions*/
+
+/*Registered and resumed tasks are injected;*/
+static void steal_inject_task(struct scheduler *sched, struct stask *task) {
+
+	struct sched_steal *policy;
+
+	/*Fetch the policy;*/
+	policy = steal_policy(sched);
+
+	/*Insert the task at the end of the injection list;*/
+	dlist_insert_single_before(&policy->s_inject, &task->t_run_list);
+	policy->s_nb_injected++;
+
+}
+
+/*Tasks resumed at once are injected in their resume order;*/
+static void steal_inject_tasks(struct scheduler *sched, struct dlist *tasks) {
+
+	struct sched_steal *policy;
+	struct stask *task;
+	struct dlist *save;
+
+	/*Fetch the policy;*/
+	policy = steal_policy(sched);
+
+	/*Insert each task at the end of the injection list;*/
+	dlist_head_for_each_object(task, save, tasks, struct stask, t_stopped) {
+		dlist_insert_single_before(&policy->s_inject, &task->t_run_list);
+		policy->s_nb_injected++;
+	}
+
+}
+
+/*Unregistered and stopped tasks are withdrawn from their queue;*/
+static void steal_withdraw_task(struct scheduler *sched, struct stask *task) {
+
+	struct sched_steal *policy;
+
+	/*Fetch the policy;*/
+	policy = steal_policy(sched);
+
+	/*If the task is queued, remove it from its deque;*/
+	if (task->t_deque) {
+		deque_remove(task);
+		return;
+	}
+
+	/*If the task is injected, remove it;*/
+	if (!dlist_empty(&task->t_run_list)) {
+		dlist_remove(&task->t_run_list);
+		policy->s_nb_injected--;
+	}
+
+}
+
+/*----------------------------------------------------------------- scheduling*/
+
+/*Tasks are not ordered; nothing to do;*/
+static void steal_schedule(struct scheduler *sched) {
+
+}
+
+/**
+ * steal_assign_one : assigns the thread a task of its local deque, or a task
+ * stolen from another thread, or an injected task; if none is available, the
+ * thread is marked inactive;
+ * @param sched : the scheduler;
+ * @param thread : the steal thread to assign a task to;
+ * @return the assigned task, 0 if none;
+ */
+static struct stask *steal_assign_one(
+		struct scheduler *sched,
+		struct sthread *thread
+) {
+
+	struct sched_steal *policy;
+	struct steal_thread *local;
+	struct stask *task;
+
+	/*Fetch the policy and the steal thread;*/
+	policy = steal_policy(sched);
+	local = steal_thread(thread);
+
+	/*Take a task from the local deque if possible;*/
+	task = sched_deque_pop(&local->s_deque);
+	if (task) {
+		local->s_nb_pops++;
+		goto assign;
+	}
+
+	/*Steal a task from another thread if possible;*/
+	task = steal_from_victims(sched, thread);
+	if (task) {
+		local->s_nb_steals++;
+		goto assign;
+	}
+
+	/*Take the first injected task if any;*/
+	if (!dlist_empty(&policy->s_inject)) {
+		task = container_of(policy->s_inject.next, struct stask, t_run_list);
+		dlist_remove(&task->t_run_list);
+		policy->s_nb_injected--;
+	}
+
+	assign:
+
+	/*Assign the task, or deactivate the thread;*/
+	thread_assign_task(thread, task);
+
+	/*Return the assigned task;*/
+	return task;
+
+}
+
+/**
+ * steal_assign_all : rebalances the queues and reassigns all threads; tasks
+ * still assigned are rotated to the top of their thread's deque, so that
+ * they are stolen first and executed last locally; injected tasks are then
+ * distributed;
+ * @param sched : the scheduler;
+ */
+static void steal_assign_all(struct scheduler *sched) {
+
+	struct sched_steal *policy;
+	struct sthread *thread;
+	struct stask *task;
+	struct dlist *head;
+	struct dlist *save;
+
+	/*Fetch the policy and the head of the threads list;*/
+	policy = steal_policy(sched);
+	head = &sched->s_threads;
+
+	/*For each thread :*/
+	dlist_head_for_each_object(thread, save, head, struct sthread, t_list) {
+
+		/*If the thread's task is still active and not queued :*/
+		task = thread->t_task;
+		if (task && (task->t_thread == thread) &&
+			(task->t_status == SCHED_STATUS_ACTIVE) &&
+			(dlist_empty(&task->t_run_list))) {
+
+			/*Rotate it to the top of the deque;*/
+			deque_push_top(&steal_thread(thread)->s_deque, task);
+
+		}
+
+	}
+
+	/*Distribute injected tasks;*/
+	steal_distribute(sched, policy);
+
+	/*Assign each thread a task;*/
+	dlist_head_for_each_object(thread, save, head, struct sthread, t_list) {
+
+		steal_assign_one(sched, thread);
+
+	}
+
+}
+
+/*----------------------------------------------------------------- priorities*/
+
+/*Overrides are ignored;*/
+static void steal_override_changed(
+		struct scheduler *sched,
+		struct sprim *prim,
+		struct stask *task
+) {
+
+}
+
+/*Priorities are ignored;*/
+static void steal_task_priority_updated(
+		struct scheduler *sched,
+		struct stask *task
+) {
+
+}
+
+/*The priority of a task is its base priority;*/
+static usize steal_get_task_priority(
+		struct scheduler *sched,
+		struct stask *task
+) {
+
+	return task->t_priority;
+
+}
+
+/*Primitives have no priority;*/
+static usize steal_prim_get_prio(struct sprim *prim) {
+
+	return 0;
+
+}
+
+/*----------------------------------------------------------------- public API*/
+
+/**
+ * sched_steal_ctor : initializes the policy and installs its operations in
+ * the scheduler; must be called before any task or thread is registered;
+ * @param policy : the policy to initialize;
+ * @param sched : the scheduler to install the policy in;
+ */
+void sched_steal_ctor(struct sched_steal *policy, struct scheduler *sched) {
+
+	/*Args check;*/
+	ns_check(policy);
+	ns_check(sched);
+
+	/*Initialize operations;*/
+	policy->s_ops.s_registered = &steal_inject_task;
+	policy->s_ops.s_unregistered = &steal_withdraw_task;
+	policy->s_ops.s_stopped = &steal_withdraw_task;
+	policy->s_ops.s_resumed = &steal_inject_task;
+	policy->s_ops.s_resumed_all = &steal_inject_tasks;
+	policy->s_ops.s_schedule = &steal_schedule;
+	policy->s_ops.s_assign_all = &steal_assign_all;
+	policy->s_ops.s_assign_one = &steal_assign_one;
+	policy->s_ops.s_primitive_override_taken = &steal_override_changed;
+	policy->s_ops.s_primitive_override_released = &steal_override_changed;
+	policy->s_ops.s_task_priority_updtaed = &steal_task_priority_updated;
+	policy->s_ops.s_get_task_priority = &steal_get_task_priority;
+	policy->s_ops.s_prim_get_prio = &steal_prim_get_prio;
+
+	/*Initialize the injection list;*/
+	dlist_init(&policy->s_inject);
+	policy->s_nb_injected = 0;
+	policy->s_nb_queued = 0;
+
+	/*Install the operations;*/
+	sched->s_ops = &policy->s_ops;
+
+}
+
+/**
+ * sched_steal_register_thread : initializes the thread's local run queue and
+ * registers the thread in the scheduler;
+ * @param sched : the scheduler to update;
+ * @param thread : the thread to register;
+ */
+void sched_steal_register_thread(
+		struct scheduler *sched,
+		struct steal_thread *thread
+) {
+
+	/*Args check;*/
+	ns_check(sched);
+	ns_check(thread);
+
+	/*Initialize the local run queue;*/
+	sched_deque_init(&thread->s_deque);
+	thread->s_nb_pops = 0;
+	thread->s_nb_steals = 0;
+
+	/*Register the thread;*/
+	sched_register_thread(sched, &thread->s_thread);
+
+}
@@ -0,0 +1,216 @@
+/*wait.c - kerneltk - GPLV3, copyleft 2019 Raphael Outhier;*/
+
+#include <sched/wait.h>
+
+#include <check.h>
+
+
+/*------------------------------------------------------------------ internals*/
+
+/**
+ * waits_bucket : determines the bucket of an address;
+ * @param waits : the wait table;
+ * @param addr : the address to hash;
+ * @return the bucket of @addr;
+ */
+static __inline__ struct dlist *waits_bucket(
+		struct sched_waits *waits,
+		volatile usize *addr
+) {
+
+	usize hash;
+
+	/*Discard the alignment bits and mix the others multiplicatively;*/
+	hash = ((usize) addr / sizeof(usize)) * (usize) 2654435761UL;
+	hash ^= hash >> 16;
+
+	return waits->w_buckets + (hash & waits->w_mask);
+
+}
+
+/**
+ * waits_find : finds the wait queue bound to the address;
+ * @param bucket : the bucket of the address;
+ * @param addr : the address to find the wait queue of;
+ * @return the wait queue bound to @addr, 0 if none;
+ */
+static struct sched_wait_queue *waits_find(
+		struct dlist *bucket,
+		volatile usize *addr
+) {
+
+	struct sched_wait_queue *queue;
+	struct dlist *save;
+
+	/*Search the bucket's list for the address;*/
+	dlist_head_for_each_object(queue, save, bucket, struct sched_wait_queue,
+		w_list) {
+		if (queue->w_addr == addr)
+			return queue;
+	}
+
+	/*No queue is bound to the address;*/
+	return 0;
+
+}
+
+/*----------------------------------------------------------------- public API*/
+
+/**
+ * sched_waits_ctor : constructs the wait table, and registers the primitives
+ * of the pooled wait queues to the provided process;
+ * @param waits : the table to construct;
+ * @param prc : the process to register the wait queues to;
+ * @param buckets : the bucket array;
+ * @param nb_buckets : the number of buckets, must be a power of 2;
+ * @param queues : the wait queue pool;
+ * @param nb_queues : the number of wait queues;
+ * @return 0 if the table was constructed, 1 if the number of buckets was
+ * invalid;
+ */
+u8 sched_waits_ctor(
+		struct sched_waits *waits,
+		struct sprocess *prc,
+		struct dlist *buckets,
+		usize nb_buckets,
+		struct sched_wait_queue *queues,
+		usize nb_queues
+) {
+
+	usize id;
+
+	/*Args check;*/
+	ns_check(waits);
+	ns_check(prc);
+	ns_check(buckets);
+	ns_check((queues) || (!nb_queues));
+
+	/*If the number of buckets is not a power of 2, fail;*/
+	if ((!nb_buckets) || (nb_buckets & (nb_buckets - 1)))
+		return 1;
+
+	/*Initialize buckets;*/
+	for (id = 0; id < nb_buckets; id++) {
+		dlist_init(buckets + id);
+	}
+	waits->w_buckets = buckets;
+	waits->w_mask = nb_buckets - 1;
+
+	/*Register wait queues and insert them in the free list;*/
+	dlist_init(&waits->w_free);
+	for (id = 0; id < nb_queues; id++) {
+		process_register_prim(prc, &queues[id].w_prim);
+		queues[id].w_addr = 0;
+		dlist_insert_single_before(&waits->w_free, &queues[id].w_list);
+	}
+	waits->w_nb_free = nb_queues;
+
+	/*Complete;*/
+	return 0;
+
+}
+
+/**
+ * sched_wait : if the word still has the expected value, stops the thread's
+ * task on the word's wait queue, and assigns a new task to the thread;
+ * @param waits : the wait table;
+ * @param addr : the address of the word to wait on;
+ * @param expected : the value the word must have for the task to wait;
+ * @param thread : the thread executing the task that must wait;
+ * @return 0 if the task was stopped, 1 if the word had another value, 2 if
+ * no wait queue was available;
+ */
+err_t sched_wait(
+		struct sched_waits *waits,
+		volatile usize *addr,
+		usize expected,
+		struct sthread *thread
+) {
+
+	struct sched_wait_queue *queue;
+	struct dlist *bucket;
+
+	/*Args check;*/
+	ns_check(waits);
+	ns_check(addr);
+	ns_check(thread);
+
+	/*If the word was modified, don't wait;*/
+	if (*addr != expected)
+		return 1;
+
+	/*Find the queue bound to the address;*/
+	bucket = waits_bucket(waits, addr);
+	queue = waits_find(bucket, addr);
+
+	/*If no queue is bound to the address :*/
+	if (!queue) {
+
+		/*If no queue is free, fail;*/
+		if (!waits->w_nb_free)
+			return 2;
+
+		/*Bind the first free queue to the address;*/
+		queue = container_of(waits->w_free.next, struct sched_wait_queue,
+			w_list);
+		dlist_remove(&queue->w_list);
+		waits->w_nb_free--;
+		queue->w_addr = addr;
+		dlist_insert_single_after(bucket, &queue->w_list);
+
+	}
+
+	/*Stop the thread's task;*/
+	primitive_stop_thread(&queue->w_prim, thread);
+
+	/*Complete;*/
+	return 0;
+
+}
+
+/**
+ * sched_wake : resumes the first tasks waiting on the word;
+ * @param waits : the wait table;
+ * @param addr : the address of the word;
+ * @param nb_tasks : the maximal number of tasks to resume;
+ * @return the number of resumed tasks;
+ */
+usize sched_wake(
+		struct sched_waits *waits,
+		volatile usize *addr,
+		usize nb_tasks
+) {
+
+	struct sched_wait_queue *queue;
+	struct stask *task;
+	usize nb_resumed;
+
+	/*Args check;*/
+	ns_check(waits);
+	ns_check(addr);
+
+	/*Find the queue bound to the address; if none, no task waits;*/
+	queue = waits_find(waits_bucket(waits, addr), addr);
+	if (!queue)
+		return 0;
+
+	/*Resume at most the required number of tasks;*/
+	for (nb_resumed = 0; nb_resumed < nb_tasks; nb_resumed++) {
+		task = primitive_first_stopped(&queue->w_prim);
+		if (!task)
+			break;
+		primitive_resume_task(task);
+	}
+
+	/*If no task waits anymore, return the queue to the pool;*/
+	if (dlist_empty(&queue->w_prim.p_stopped)) {
+		dlist_remove(&queue->w_list);
+		queue->w_addr = 0;
+		dlist_insert_single_before(&waits->w_free, &queue->w_list);
+		waits->w_nb_free++;
+	}
+
+	/*Complete;*/
+	return nb_resumed;
+
+}
@@ -0,0 +1,701 @@
+/*bench.c - kerneltk - GPLV3, copyleft 2019 Raphael Outhier;*/
+
+/*
+ * Loader benchmark : generates a synthetic relocatable elf64 object with a
+ * configurable number of sections, symbols, imports and relocations per type,
+ * loads it repeatedly, and reports ns per symbol and ns per relocation
+ * percentiles;
+ *
+ * usage : bench [-s sections] [-y symbols] [-i imports] [-n iterations]
+ *               [-q queries] [-r type count]... [-ns] [-j workers]
+ *               [-B modules]
+ *
+ * -r can be provided several times, one for each relocation type; if no -r
+ * is provided, R_AMD64_PC32 and R_AMD64_PLT32 relocations are generated;
+ * -ns resolves imports against a namespace rather than a symbol list;
+ * -j assigns symbols in parallel on the provided number of threads, against
+ * the namespace; the query index is rebuilt at each load;
+ * -q queries the provided number of defined symbols; a checksum of query
+ * definitions is printed, that must not depend on -ns or -j;
+ * -B loads the provided number of copies of the object as one batch per
+ * iteration, and reports the cost of a load per module;
+ */
+
+#define _POSIX_C_SOURCE 200112L
+#define _ISOC11_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <loader/loader.h>
+
+/*The maximal number of relocation types;*/
+#define BENCH_MAX_REL_TYPES 8
+
+/*The size of a symbol or import slot in a section;*/
+#define BENCH_SLOT_SIZE 8
+
+/**
+ * Benchmark configuration;
+ */
+struct bench_cfg {
+
+	/*The number of text sections;*/
+	usize b_nb_sections;
+
+	/*The number of defined symbols;*/
+	usize b_nb_symbols;
+
+	/*The number of undefined symbols, resolved externally;*/
+	usize b_nb_imports;
+
+	/*The number of load iterations;*/
+	usize b_nb_iterations;
+
+	/*Relocation types and counts;*/
+	u32 b_rel_types[BENCH_MAX_REL_TYPES];
+	usize b_rel_counts[BENCH_MAX_REL_TYPES];
+	usize b_nb_rel_types;
+
+	/*The total number of relocations;*/
+	usize b_nb_relocations;
+
+	/*A flag, set if imports must be resolved against a namespace;*/
+	u8 b_namespace;
+
+	/*The number of symbol queries;*/
+	usize b_nb_queries;
+
+	/*The number of symbol assignment workers, 0 for serial assignment;*/
+	usize b_nb_workers;
+
+	/*The number of modules per batch, 0 to load modules one by one;*/
+	usize b_nb_batch;
+
+};
+
+/**
+ * Synthetic object layout, offsets in bytes from the start of the image;
+ */
+struct bench_obj {
+
+	/*The pristine image and its size;*/
+	u8 *o_image;
+	usize o_size;
+
+	/*The size of one text section;*/
+	usize o_text_size;
+
+	/*The index of the first text section header;*/
+	u16 o_text_id;
+
+	/*The index of the import area, symbol and string tables headers;*/
+	u16 o_imports_id;
+	u16 o_symtab_id;
+	u16 o_strtab_id;
+
+	/*The offset of the import area;*/
+	usize o_imports_off;
+
+	/*The offset of the string table and of the imports names in it;*/
+	usize o_strtab_off;
+	usize o_import_names_off;
+
+};
+
+/*------------------------------------------------------------------ generator*/
+
+/**
+ * align : rounds up @value to a multiple of 8;
+ */
+static usize align(usize value)
+{
+	return (value + 7) & ~(usize) 7;
+}
+
+/**
+ * bench_generate : generates the synthetic object described by @cfg;
+ * Layout : header, text sections, import area, symbol table, string table,
+ * one relocation table per text section, section header table;
+ * @param cfg : the benchmark configuration;
+ * @param obj : the object to initialize;
+ */
+static void bench_generate(struct bench_cfg *cfg, struct bench_obj *obj)
+{
+
+	usize nb_sections, nb_syms, nb_shdrs, rels_per_section;
+	usize text_off, symtab_off, rela_off, shdr_off, strtab_size, offset;
+	usize id, rel_id, type_id, type_left;
+	struct elf64_hdr *hdr;
+	struct elf64_shdr *shdr;
+	struct elf64_sym *sym;
+	struct elf64_rela *rela;
+	char *strtab;
+	u8 *image;
+
+	nb_sections = cfg->b_nb_sections;
+	nb_syms = 1 + cfg->b_nb_symbols + cfg->b_nb_imports;
+	rels_per_section = (cfg->b_nb_relocations + nb_sections - 1) / nb_sections;
+
+	/*Null header, text sections, imports, symtab, strtab, relocations;*/
+	nb_shdrs = 1 + nb_sections + 3 + nb_sections;
+
+	/*Each text section holds one slot per relocation and per symbol;*/
+	obj->o_text_size = align(BENCH_SLOT_SIZE * (rels_per_section +
+		cfg->b_nb_symbols / nb_sections + 1));
+
+	/*Determine the string table size, names are "s%lx" and "i%lx";*/
+	strtab_size = 1 + (cfg->b_nb_symbols + cfg->b_nb_imports) * 18;
+
+	/*Determine section offsets;*/
+	text_off = align(sizeof(struct elf64_hdr));
+	obj->o_imports_off = text_off + nb_sections * obj->o_text_size;
+	symtab_off = align(obj->o_imports_off +
+		(cfg->b_nb_imports + 1) * BENCH_SLOT_SIZE);
+	obj->o_strtab_off = symtab_off + nb_syms * sizeof(struct elf64_sym);
+	rela_off = align(obj->o_strtab_off + strtab_size);
+	shdr_off = align(rela_off + nb_sections * rels_per_section *
+		sizeof(struct elf64_rela));
+	obj->o_size = shdr_off + nb_shdrs * sizeof(struct elf64_shdr);
+
+	/*Allocate and reset the image;*/
+	obj->o_image = image = calloc(1, obj->o_size);
+	if (!image) {
+		printf("allocation error;\n");
+		exit(1);
+	}
+
+	/*Section indices;*/
+	obj->o_text_id = 1;
+	obj->o_imports_id = (u16) (1 + nb_sections);
+	obj->o_symtab_id = (u16) (obj->o_imports_id + 1);
+	obj->o_strtab_id = (u16) (obj->o_imports_id + 2);
+
+	/*
+	 * Header;
+	 */
+
+	hdr = (struct elf64_hdr *) image;
+	hdr->e_ident.ei_mag0 = ELFMAG0;
+	hdr->e_ident.ei_mag1 = ELFMAG1;
+	hdr->e_ident.ei_mag2 = ELFMAG2;
+	hdr->e_ident.ei_mag3 = ELFMAG3;
+	hdr->e_ident.ei_class = ELFCLASS64;
+	hdr->e_ident.ei_data = ELFDATA2LSB;
+	hdr->e_ident.ei_version = EV_CURRENT;
+	hdr->e_type = ET_REL;
+	hdr->e_machine = EM_X86_64;
+	hdr->e_version = EV_CURRENT;
+	hdr->e_shoff = shdr_off;
+	hdr->e_ehsize = sizeof(struct elf64_hdr);
+	hdr->e_shentsize = sizeof(struct elf64_shdr);
+	hdr->e_shnum = (u16) nb_shdrs;
+
+	/*
+	 * Section headers;
+	 */
+
+	shdr = (struct elf64_shdr *) (image + shdr_off);
+
+	for (id = 0; id < nb_sections; id++) {
+
+		/*Text section;*/
+		shdr[obj->o_text_id + id].sh_type = SHT_PROGBITS;
+		shdr[obj->o_text_id + id].sh_offset = text_off +
+			id * obj->o_text_size;
+		shdr[obj->o_text_id + id].sh_size = obj->o_text_size;
+		shdr[obj->o_text_id + id].sh_addralign = BENCH_SLOT_SIZE;
+
+		/*Its relocation table;*/
+		shdr[obj->o_strtab_id + 1 + id].sh_type = SHT_RELA;
+		shdr[obj->o_strtab_id + 1 + id].sh_offset = rela_off +
+			id * rels_per_section * sizeof(struct elf64_rela);
+		shdr[obj->o_strtab_id + 1 + id].sh_size = 0;
+		shdr[obj->o_strtab_id + 1 + id].sh_link = obj->o_symtab_id;
+		shdr[obj->o_strtab_id + 1 + id].sh_info = (u32) (obj->o_text_id + id);
+		shdr[obj->o_strtab_id + 1 + id].sh_entsize = sizeof(struct elf64_rela);
+
+	}
+
+	shdr[obj->o_imports_id].sh_type = SHT_PROGBITS;
+	shdr[obj->o_imports_id].sh_offset = obj->o_imports_off;
+	shdr[obj->o_imports_id].sh_size = (cfg->b_nb_imports + 1) *
+		BENCH_SLOT_SIZE;
+
+	shdr[obj->o_symtab_id].sh_type = SHT_SYMTAB;
+	shdr[obj->o_symtab_id].sh_offset = symtab_off;
+	shdr[obj->o_symtab_id].sh_size = nb_syms * sizeof(struct elf64_sym);
+	shdr[obj->o_symtab_id].sh_link = obj->o_strtab_id;
+	shdr[obj->o_symtab_id].sh_info = 1;
+	shdr[obj->o_symtab_id].sh_entsize = sizeof(struct elf64_sym);
+
+	shdr[obj->o_strtab_id].sh_type = SHT_STRTAB;
+	shdr[obj->o_strtab_id].sh_offset = obj->o_strtab_off;
+	shdr[obj->o_strtab_id].sh_size = strtab_size;
+	shdr[obj->o_strtab_id].sh_entsize = 1;
+
+	/*
+	 * Symbols and names;
+	 */
+
+	sym = (struct elf64_sym *) (image + symtab_off);
+	strtab = (char *) (image + obj->o_strtab_off);
+	offset = 1;
+
+	/*Defined symbols are spread over text sections, after relocation slots;*/
+	for (id = 0; id < cfg->b_nb_symbols; id++) {
+
+		sym[1 + id].sy_name = (u32) offset;
+		sym[1 + id].sy_info = (1 << 4) | 2;
+		sym[1 + id].sy_shndx = (u16) (obj->o_text_id + id % nb_sections);
+		sym[1 + id].sy_value = BENCH_SLOT_SIZE *
+			(rels_per_section + id / nb_sections);
+		offset += (usize) sprintf(strtab + offset, "s%lx", (unsigned long) id)
+			+ 1;
+
+	}
+
+	/*Imports are undefined;*/
+	obj->o_import_names_off = offset;
+	for (id = 0; id < cfg->b_nb_imports; id++) {
+
+		sym[1 + cfg->b_nb_symbols + id].sy_name = (u32) offset;
+		sym[1 + cfg->b_nb_symbols + id].sy_info = (1 << 4) | 2;
+		sym[1 + cfg->b_nb_symbols + id].sy_shndx = SHN_UNDEF;
+		offset += (usize) sprintf(strtab + offset, "i%lx", (unsigned long) id)
+			+ 1;
+
+	}
+
+	/*
+	 * Relocations, distributed round-robin over text sections;
+	 */
+
+	type_id = 0;
+	type_left = cfg->b_rel_counts[0];
+	for (rel_id = 0; rel_id < cfg->b_nb_relocations; rel_id++) {
+
+		struct elf64_shdr *rel_hdr;
+		usize section, slot;
+
+		/*Switch to the next type when the current one is exhausted;*/
+		while (!type_left)
+			type_left = cfg->b_rel_counts[++type_id];
+		type_left--;
+
+		/*Determine the section and the slot in this section;*/
+		section = rel_id % nb_sections;
+		slot = rel_id / nb_sections;
+		rel_hdr = shdr + obj->o_strtab_id + 1 + section;
+
+		/*Append the relocation to the section's relocation table;*/
+		rela = (struct elf64_rela *) (image + rel_hdr->sh_offset) + slot;
+		rel_hdr->sh_size += sizeof(struct elf64_rela);
+		rela->r_offset = slot * BENCH_SLOT_SIZE;
+		rela->r_info = ELF64_R_INFO(1 + rel_id % (nb_syms - 1),
+			cfg->b_rel_types[type_id]);
+		rela->r_addend = -4;
+
+	}
+
+}
+
+/*------------------------------------------------------------------ execution*/
+
+/**
+ * now_ns : reads the monotonic clock;
+ * @return the current time in ns;
+ */
+static u64 now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64) ts.tv_sec * 1000000000 + (u64) ts.tv_nsec;
+}
+
+/**
+ * cmp_u64 : qsort comparison function for u64;
+ */
+static int cmp_u64(const void *a, const void *b)
+{
+	u64 va = *(const u64 *) a, vb = *(const u64 *) b;
+	return (va < vb) ? -1 : (va > vb);
+}
+
+/**
+ * report : sorts samples and prints percentiles of per-item costs;
+ * @param name : the name of the metric;
+ * @param samples : the ns count of each iteration;
+ * @param nb_samples : the number of samples;
+ * @param nb_items : the number of items processed in each iteration;
+ */
+static void report(const char *name, u64 *samples, usize nb_samples,
+	usize nb_items)
+{
+
+	double div;
+
+	qsort(samples, nb_samples, sizeof(u64), &cmp_u64);
+	div = (nb_items) ? (double) nb_items : 1.0;
+
+	printf("%-16s p50 %9.2f  p90 %9.2f  p99 %9.2f  max %9.2f\n", name,
+		samples[nb_samples / 2] / div,
+		samples[nb_samples * 90 / 100] / div,
+		samples[nb_samples * 99 / 100] / div,
+		samples[nb_samples - 1] / div);
+
+}
+
+/**
+ * parse_args : initializes @cfg from command line arguments;
+ */
+static void parse_args(struct bench_cfg *cfg, int argc, char *argv[])
+{
+
+	int id;
+
+	cfg->b_nb_sections = 16;
+	cfg->b_nb_symbols = 4096;
+	cfg->b_nb_imports = 1024;
+	cfg->b_nb_iterations = 200;
+	cfg->b_nb_rel_types = 0;
+	cfg->b_namespace = 0;
+	cfg->b_nb_queries = 0;
+	cfg->b_nb_workers = 0;
+	cfg->b_nb_batch = 0;
+
+	for (id = 1; id < argc; id++) {
+
+		if ((!strcmp(argv[id], "-ns"))) {
+			cfg->b_namespace = 1;
+		} else if ((!strcmp(argv[id], "-r")) && (id + 2 < argc) &&
+			(cfg->b_nb_rel_types < BENCH_MAX_REL_TYPES)) {
+			cfg->b_rel_types[cfg->b_nb_rel_types] =
+				(u32) strtoul(argv[++id], 0, 0);
+			cfg->b_rel_counts[cfg->b_nb_rel_types++] =
+				strtoul(argv[++id], 0, 0);
+		} else if (id + 1 < argc) {
+			usize *dst;
+			if (!strcmp(argv[id], "-s")) dst = &cfg->b_nb_sections;
+			else if (!strcmp(argv[id], "-y")) dst = &cfg->b_nb_symbols;
+			else if (!strcmp(argv[id], "-i")) dst = &cfg->b_nb_imports;
+			else if (!strcmp(argv[id], "-n")) dst = &cfg->b_nb_iterations;
+			else if (!strcmp(argv[id], "-q")) dst = &cfg->b_nb_queries;
+			else if (!strcmp(argv[id], "-j")) dst = &cfg->b_nb_workers;
+			else if (!strcmp(argv[id], "-B")) dst = &cfg->b_nb_batch;
+			else goto usage;
+			*dst = strtoul(argv[++id], 0, 0);
+		} else {
+			goto usage;
+		}
+
+	}
+
+	/*Default relocation mix : R_AMD64_PC32 and R_AMD64_PLT32;*/
+	if (!cfg->b_nb_rel_types) {
+		cfg->b_rel_types[0] = 2;
+		cfg->b_rel_counts[0] = 8192;
+		cfg->b_rel_types[1] = 4;
+		cfg->b_rel_counts[1] = 8192;
+		cfg->b_nb_rel_types = 2;
+	}
+
+	cfg->b_nb_relocations = 0;
+	for (id = 0; id < (int) cfg->b_nb_rel_types; id++)
+		cfg->b_nb_relocations += cfg->b_rel_counts[id];
+
+	/*Each relocation needs a symbol, and the image needs a section;*/
+	if ((!cfg->b_nb_sections) || (!cfg->b_nb_iterations) ||
+		(cfg->b_nb_relocations && !(cfg->b_nb_symbols + cfg->b_nb_imports)) ||
+		(cfg->b_nb_queries > cfg->b_nb_symbols))
+		goto usage;
+
+	return;
+
+	usage:
+	printf("usage : %s [-s sections] [-y symbols] [-i imports] "
+		"[-n iterations] [-q queries] [-r type count]... [-ns] "
+		"[-j workers] [-B modules]\n", argv[0]);
+	exit(1);
+
+}
+
+/**
+ * bench_worker : pthread entry, processes one chunk;
+ */
+static void *bench_worker(void *chunk)
+{
+	loader_assign_symbols_chunk(chunk);
+	return 0;
+}
+
+/**
+ * bench_run : processes one chunk per thread, the first one in the calling
+ * thread, and joins;
+ */
+static void bench_run(void *threads, struct loader_symbols_chunk *chunks,
+	usize nb)
+{
+
+	usize id;
+
+	for (id = 1; id < nb; id++)
+		pthread_create((pthread_t *) threads + id, 0, &bench_worker,
+			chunks + id);
+
+	loader_assign_symbols_chunk(chunks);
+
+	for (id = 1; id < nb; id++)
+		pthread_join(((pthread_t *) threads)[id], 0);
+
+}
+
+/**
+ * bench_batch : loads @cfg->b_nb_batch copies of the object as one batch per
+ * iteration, imports being resolved in the first module's import area;
+ * @return 0 if all loads succeeded, 1 if not;
+ */
+static u8 bench_batch(struct bench_cfg *cfg, struct bench_obj *obj,
+	struct loader_symbol *defs, struct loader_export *exports,
+	struct loader_namespace *ns, u64 *t_total)
+{
+
+	struct loader_module *modules;
+	struct loader_batch batch;
+	usize arena_size, it, id;
+	u8 *arena;
+
+	/*Allocate modules and the arena;*/
+	modules = calloc(cfg->b_nb_batch, sizeof(struct loader_module));
+	if (!modules)
+		return 1;
+	for (id = 0; id < cfg->b_nb_batch; id++)
+		modules[id].m_size = obj->o_size;
+	arena_size = loader_batch_arena_size(modules, cfg->b_nb_batch);
+	arena = aligned_alloc(LOADER_BATCH_ALIGN, arena_size);
+	if ((!arena) || loader_batch_init(&batch, modules, cfg->b_nb_batch, arena,
+		arena_size))
+		return 1;
+
+	/*Imports resolve in the first module;*/
+	for (id = 0; id < cfg->b_nb_imports; id++)
+		defs[id].s_addr = exports[id].e_addr = (u8 *) modules[0].m_image +
+			obj->o_imports_off + id * BENCH_SLOT_SIZE;
+
+	for (it = 0; it < cfg->b_nb_iterations; it++) {
+
+		u64 t0;
+
+		/*Read all images;*/
+		for (id = 0; id < cfg->b_nb_batch; id++)
+			memcpy(modules[id].m_image, obj->o_image, obj->o_size);
+
+		t0 = now_ns();
+
+		if (loader_batch_load(&batch, (cfg->b_namespace) ? 0 : defs,
+			(cfg->b_namespace) ? ns : 0, 0)) {
+			for (id = 0; !modules[id].m_error; id++);
+			printf("module %lu failed in phase %d with error %d;\n",
+				(unsigned long) id, modules[id].m_phase, modules[id].m_error);
+			return 1;
+		}
+
+		t_total[it] = now_ns() - t0;
+
+	}
+
+	printf("ns per item :\n");
+	report("module", t_total, cfg->b_nb_iterations, cfg->b_nb_batch);
+
+	return 0;
+
+}
+
+int main(int argc, char *argv[])
+{
+
+	struct bench_cfg cfg;
+	struct bench_obj obj;
+	struct loader_symbol *defs;
+	struct loader_export *exports;
+	struct loader_export **buckets;
+	usize *bloom;
+	usize nb_buckets, bloom_words;
+	struct loader_export_table table;
+	struct loader_namespace ns;
+	struct loading_env env;
+	struct loader_symbol *queries;
+	struct loader_export *q_exports, **q_buckets;
+	usize *q_winners, *q_bloom, q_bloom_words, checksum;
+	struct loader_symbols_job job;
+	struct loader_symbols_chunk *chunks;
+	pthread_t *threads;
+	u64 *t_layout, *t_symbols, *t_relocs, *t_total;
+	usize it, id;
+	u8 *work;
+	u8 error;
+
+	parse_args(&cfg, argc, argv);
+	bench_generate(&cfg, &obj);
+
+	printf("sections %lu, symbols %lu, imports %lu, relocations %lu, "
+		"queries %lu, image %lu bytes, %lu iterations%s, %lu workers\n",
+		(unsigned long) cfg.b_nb_sections, (unsigned long) cfg.b_nb_symbols,
+		(unsigned long) cfg.b_nb_imports,
+		(unsigned long) cfg.b_nb_relocations,
+		(unsigned long) cfg.b_nb_queries, (unsigned long) obj.o_size,
+		(unsigned long) cfg.b_nb_iterations,
+		(cfg.b_namespace) ? ", namespace" : "",
+		(unsigned long) cfg.b_nb_workers);
+
+	/*Allocate the working image and the samples;*/
+	work = malloc(obj.o_size);
+	defs = calloc(cfg.b_nb_imports + 1, sizeof(struct loader_symbol));
+	exports = calloc(cfg.b_nb_imports + 1, sizeof(struct loader_export));
+	for (bloom_words = 1; bloom_words < cfg.b_nb_imports / 32;)
+		bloom_words <<= 1;
+	nb_buckets = cfg.b_nb_imports + 1;
+	buckets = calloc(nb_buckets, sizeof(struct loader_export *));
+	bloom = calloc(bloom_words, sizeof(usize));
+	t_layout = calloc(cfg.b_nb_iterations, sizeof(u64));
+	t_symbols = calloc(cfg.b_nb_iterations, sizeof(u64));
+	t_relocs = calloc(cfg.b_nb_iterations, sizeof(u64));
+	t_total = calloc(cfg.b_nb_iterations, sizeof(u64));
+	queries = calloc(cfg.b_nb_queries + 1, sizeof(struct loader_symbol));
+	q_exports = calloc(cfg.b_nb_queries + 1, sizeof(struct loader_export));
+	q_winners = calloc(cfg.b_nb_queries + 1, sizeof(usize));
+	q_buckets = calloc(cfg.b_nb_queries + 1, sizeof(struct loader_export *));
+	for (q_bloom_words = 1; q_bloom_words < cfg.b_nb_queries / 32;)
+		q_bloom_words <<= 1;
+	q_bloom = calloc(q_bloom_words, sizeof(usize));
+	chunks = calloc(cfg.b_nb_workers + 1,
+		sizeof(struct loader_symbols_chunk));
+	threads = calloc(cfg.b_nb_workers + 1, sizeof(pthread_t));
+	if (!(work && defs && exports && buckets && bloom && t_layout &&
+		t_symbols && t_relocs && t_total && queries && q_exports &&
+		q_winners && q_buckets && q_bloom && chunks && threads)) {
+		printf("allocation error;\n");
+		return 1;
+	}
+
+	/*Imports are defined in the working image's import area, so that
+	 * relative relocations never overflow; names are consecutive in the
+	 * string table;*/
+	{
+		const char *name = (const char *) obj.o_image + obj.o_strtab_off +
+			obj.o_import_names_off;
+		for (id = 0; id < cfg.b_nb_imports; id++) {
+			defs[id].s_next = (id + 1 < cfg.b_nb_imports) ? defs + id + 1 : 0;
+			defs[id].s_defined = 1;
+			defs[id].s_name = exports[id].e_name = name;
+			defs[id].s_addr = exports[id].e_addr =
+				work + obj.o_imports_off + id * BENCH_SLOT_SIZE;
+			name += strlen(name) + 1;
+		}
+	}
+
+	/*Queries reference the first defined symbols;*/
+	{
+		const char *name = (const char *) obj.o_image + obj.o_strtab_off + 1;
+		for (id = 0; id < cfg.b_nb_queries; id++) {
+			queries[id].s_next = (id + 1 < cfg.b_nb_queries) ?
+				queries + id + 1 : 0;
+			queries[id].s_name = name;
+			name += strlen(name) + 1;
+		}
+	}
+
+	/*Build the namespace;*/
+	loader_namespace_init(&ns);
+	if (loader_export_table_init(&table, exports, cfg.b_nb_imports,
+		buckets, nb_buckets, bloom, bloom_words)) {
+		printf("export table error;\n");
+		return 1;
+	}
+	loader_namespace_push(&ns, &table);
+
+	/*In batch mode, modules are loaded by the batch routine;*/
+	if (cfg.b_nb_batch)
+		return bench_batch(&cfg, &obj, defs, exports, &ns, t_total);
+
+	checksum = 0;
+	for (it = 0; it < cfg.b_nb_iterations; it++) {
+
+		u64 t0, t1, t2, t3;
+
+		/*Restore the pristine image and reset queries;*/
+		memcpy(work, obj.o_image, obj.o_size);
+		for (id = 0; id < cfg.b_nb_queries; id++) {
+			queries[id].s_defined = 0;
+			queries[id].s_addr = 0;
+		}
+
+		t0 = now_ns();
+
+		loader_init(&env, work);
+		error = loader_assign_sections(&env);
+		if (error)
+			goto load_error;
+
+		t1 = now_ns();
+
+		if (cfg.b_nb_workers) {
+			error = loader_symbols_job_init(&job, &env, &ns,
+				(cfg.b_nb_queries) ? queries : 0, q_exports, q_winners,
+				q_buckets, cfg.b_nb_queries + 1, q_bloom, q_bloom_words);
+			if (!error)
+				error = (u8) loader_assign_symbols_par(&job, chunks,
+					cfg.b_nb_workers, &bench_run, threads);
+		} else if (cfg.b_namespace) {
+			error = (u8) loader_assign_symbols_ns(&env, &ns,
+				(cfg.b_nb_queries) ? queries : 0);
+		} else {
+			error = (u8) loader_assign_symbols(&env,
+				(cfg.b_nb_imports) ? defs : 0,
+				(cfg.b_nb_queries) ? queries : 0);
+		}
+		if (error)
+			goto load_error;
+
+		t2 = now_ns();
+
+		error = rmld_apply_relocations(&env);
+		if (error)
+			goto load_error;
+
+		t3 = now_ns();
+
+		t_layout[it] = t1 - t0;
+		t_symbols[it] = t2 - t1;
+		t_relocs[it] = t3 - t2;
+		t_total[it] = t3 - t0;
+
+		/*Accumulate query definitions, relative to the image;*/
+		for (id = 0; id < cfg.b_nb_queries; id++) {
+			if (queries[id].s_defined)
+				checksum += (id + 1) * (usize)
+					((u8 *) queries[id].s_addr - work);
+		}
+
+	}
+
+	printf("queries checksum : %lx\n", (unsigned long) checksum);
+
+	printf("ns per item :\n");
+	report("section", t_layout, cfg.b_nb_iterations, cfg.b_nb_sections);
+	report("symbol", t_symbols, cfg.b_nb_iterations,
+		cfg.b_nb_symbols + cfg.b_nb_imports);
+	report("relocation", t_relocs, cfg.b_nb_iterations,
+		cfg.b_nb_relocations);
+	report("load", t_total, cfg.b_nb_iterations, 1);
+
+	return 0;
+
+	load_error:
+	printf("loading error %d at iteration %lu;\n", error, (unsigned long) it);
+	return 1;
+
+}
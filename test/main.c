@@ -16,6 +16,12 @@ u32 a;
 u32 b;
 u32 c;
 
+static void print_stat(void *arg, const char *name, usize index, u64 value)
+{
+	printf("  %s[%lu] : %lu\n", name, (unsigned long) index,
+		(unsigned long) value);
+}
+
 int main(int argc, char *argv[])
 {
 	
@@ -26,6 +32,7 @@ int main(int argc, char *argv[])
 	struct loader_symbol prtf;
 	struct loader_symbol func;
 	struct loading_env rel;
+	struct loader_stats stats;
 	u8 error;
 	u32 (*fnc)(void);
 	u32 res;
@@ -63,7 +70,9 @@ int main(int argc, char *argv[])
 	
 	printf("hdr : %p\n", addr);
 	
-	loader_init(&rel, addr, file_size);
+	loader_stats_reset(&stats);
+	
+	loader_init_stats(&rel, addr, &stats);
 	
 	error = loader_assign_sections(&rel);
 	
@@ -77,6 +86,10 @@ int main(int argc, char *argv[])
 	
 	printf("rellocation application : %d\n", error);
 	
+	printf("loader stats :\n");
+	
+	loader_stats_dump(&stats, &print_stat, 0);
+	
 	printf("func : %p\n", func.s_addr);
 	
 	fnc = func.s_addr;
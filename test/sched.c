@@ -0,0 +1,187 @@
+/*sched.c - kerneltk - GPLV3, copyleft 2019 Raphael Outhier;*/
+
+/*
+ * Scheduler test : drives a scheduler with the priority policy from a single
+ * host thread, the scheduler threads being simulated, and checks the state of
+ * tasks after sequences of primitive operations and commits;
+ *
+ * usage : sched
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <sched/sched.h>
+#include <sched/prio.h>
+#include <sched/mutex.h>
+
+/*The number of scheduler threads;*/
+#define TEST_NB_THREADS 2
+
+/*The number of tasks;*/
+#define TEST_NB_TASKS 3
+
+/*Fails the current test if the condition is false;*/
+#define test_check(cond) \
+	{ if (!(cond)) { printf("%s:%d : check failed : %s;\n", __FILE__, \
+		__LINE__, #cond); return 1; } }
+
+/**
+ * Test environment : a scheduler with one process, and threads and tasks
+ * registered to it;
+ */
+struct test_env {
+
+	/*The scheduler and its policy;*/
+	struct scheduler e_sched;
+	struct sched_prio e_policy;
+
+	/*The process;*/
+	struct sprocess e_process;
+
+	/*Threads and tasks;*/
+	struct sthread e_threads[TEST_NB_THREADS];
+	struct stask e_tasks[TEST_NB_TASKS];
+
+};
+
+/**
+ * test_setup : initializes the scheduler, registers the process, threads and
+ * tasks, the task i having the priority i + 1, and assigns tasks to threads
+ * with a first commit;
+ * @param env : the environment to initialize;
+ */
+static void test_setup(struct test_env *env)
+{
+
+	usize id;
+
+	memset(env, 0, sizeof(struct test_env));
+
+	sched_ctor(&env->e_sched);
+	sched_prio_ctor(&env->e_policy, &env->e_sched);
+	sched_register_process(&env->e_sched, &env->e_process);
+	for (id = 0; id < TEST_NB_THREADS; id++)
+		sched_register_thread(&env->e_sched, env->e_threads + id);
+	for (id = 0; id < TEST_NB_TASKS; id++) {
+		env->e_tasks[id].t_priority = id + 1;
+		process_register_task(&env->e_process, env->e_tasks + id);
+	}
+
+	sched_open_commit(&env->e_sched);
+	sched_close_commit(&env->e_sched);
+
+}
+
+/**
+ * test_thread_of : returns the thread executing the task;
+ * @param env : the environment;
+ * @param task : the task;
+ * @return the thread executing the task, 0 if it is not executed;
+ */
+static struct sthread *test_thread_of(struct test_env *env, struct stask *task)
+{
+
+	usize id;
+
+	for (id = 0; id < TEST_NB_THREADS; id++) {
+		if (env->e_threads[id].t_task == task)
+			return env->e_threads + id;
+	}
+
+	return 0;
+
+}
+
+/**
+ * test_journal_stop_resume : in journal mode, stops an executed task on a
+ * contended mutex, and resumes it before the next commit close; the task must
+ * be executed or queued after the commit;
+ * @return 0 if the test passed, 1 if not;
+ */
+static u8 test_journal_stop_resume(void)
+{
+
+	struct test_env env;
+	struct sched_mutex mutex;
+	struct sthread *owner;
+	struct sthread *waiter;
+	struct stask *task;
+
+	test_setup(&env);
+	sched_mutex_ctor(&mutex, &env.e_process);
+	sched_set_journaled(&env.e_sched, 1);
+
+	/*The two most urgent tasks are executed;*/
+	owner = test_thread_of(&env, env.e_tasks + 2);
+	waiter = test_thread_of(&env, env.e_tasks + 1);
+	test_check(owner && waiter);
+
+	/*The waiter's task is stopped, and the waiter executes the last task;*/
+	task = waiter->t_task;
+	test_check(sched_mutex_lock_fast(&mutex, owner) == 1);
+	test_check(sched_mutex_lock_fast(&mutex, waiter) == 0);
+	test_check(task->t_status == SCHED_STATUS_STOPPED);
+	test_check(waiter->t_task == env.e_tasks);
+
+	/*The stopped task is resumed before the commit;*/
+	test_check(sched_mutex_unlock_fast(&mutex, owner) == 0);
+	test_check(task->t_status == SCHED_STATUS_ACTIVE);
+
+	/*After the commit, the task is executed or queued;*/
+	sched_open_commit(&env.e_sched);
+	sched_close_commit(&env.e_sched);
+	test_check(!(task->t_flags & STASK_STATUS_JOURNALED));
+	test_check((test_thread_of(&env, task)) ||
+		(sched_prio_top(&env.e_policy) == task));
+
+	return 0;
+
+}
+
+/**
+ * test_deferred_priority : updates the priority of a task, and closes a
+ * commit while its process is locked; the priority must be recomputed when
+ * the process is unlocked;
+ * @return 0 if the test passed, 1 if not;
+ */
+static u8 test_deferred_priority(void)
+{
+
+	struct test_env env;
+	struct sched_lock_node node;
+	struct stask *task;
+
+	test_setup(&env);
+	task = env.e_tasks;
+
+	/*Update the priority, and close a commit with the process locked;*/
+	process_lock_wait(&env.e_process, &node);
+	task_set_priority(task, 5);
+	sched_open_commit(&env.e_sched);
+	sched_close_commit(&env.e_sched);
+	test_check(task->t_effective == 1);
+	test_check(env.e_process.p_deferred);
+
+	/*The priority is recomputed when the process is unlocked;*/
+	process_unlock(&env.e_process);
+	test_check(task->t_effective == 5);
+	test_check(!env.e_process.p_deferred);
+
+	return 0;
+
+}
+
+int main(void)
+{
+
+	u8 failed;
+
+	failed = 0;
+	failed |= test_journal_stop_resume();
+	failed |= test_deferred_priority();
+
+	printf("%s;\n", (failed) ? "failed" : "passed");
+	return failed;
+
+}